@@ -3,11 +3,15 @@
 
 #include "algorithms/binary-search-operations.hxx"
 #include "algorithms/comparison-operations.hxx"
+#include "algorithms/external-sorting-operations.hxx"
 #include "algorithms/heap-operations.hxx"
 #include "algorithms/min-max-operations.hxx"
 #include "algorithms/modifying-sequence-operations.hxx"
 #include "algorithms/non-modifying-sequence-operations.hxx"
+#include "algorithms/parallel-operations.hxx"
 #include "algorithms/partitioning-operations.hxx"
 #include "algorithms/permutation-operations.hxx"
 #include "algorithms/set-operations.hxx"
+#include "algorithms/simd-operations.hxx"
 #include "algorithms/sorting-operations.hxx"
+#include "algorithms/zip-iterator.hxx"
@@ -0,0 +1,558 @@
+
+#pragma once
+
+// ------- External sorting operations
+// external-sort
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sorting-operations.hxx"
+
+namespace learn_std
+{
+// --------------------------------------------------------------- external-sort
+// Sorts fixed-size records that need not fit in memory, from a file (or from
+// memory, such as a memory-mapped file) into a file. Record storage never
+// exceeds mem_budget bytes:
+//  1. the input is read one budget-sized chunk at a time, sorted with
+//     pdq_sort, which takes no memory on the side, and spilled to a
+//     temporary file as a run
+//  2. runs are merged k at a time, through a loser tree over their current
+//     records. Every run is read through two blocks: one is consumed while
+//     the other is filled on another thread. The output is written the same
+//     way. k is as many runs as the budget can give their blocks.
+//  3. the merges cascade: as soon as there are k runs of a level, they are
+//     merged into one run of the next level, with the chunk's memory handed
+//     to the merge meanwhile. Open files stay under k per level, and each
+//     record is merged once per level. What is left at the end is merged
+//     to the output.
+// Input that fits in one chunk is written straight to the output. The sort
+// is not stable.
+// Raw records are compared with comp(const unsigned char*, const unsigned
+// char*); the overloads taking a type T compare T's and sort runs in place.
+// Temporary files go in tmp_dir, or are std::tmpfile()s if it is empty, and
+// are deleted on the way out, also when an exception is thrown. I/O errors
+// throw std::system_error; input that is not a whole number of records, or
+// a budget too small for six of them, throws std::invalid_argument.
+namespace detail
+{
+   constexpr std::size_t k_external_max_fan_in   = 64;
+   constexpr std::size_t k_external_min_block    = 1 << 16; // bytes
+   constexpr int k_external_temporary_file_tries = 16;
+
+   [[noreturn]] inline void throw_io_error(const std::string& what)
+   {
+      throw std::system_error(
+          errno, std::generic_category(), "external_sort: " + what);
+   }
+
+   struct file_closer
+   {
+      void operator()(std::FILE* f) const noexcept { std::fclose(f); }
+   };
+   using file_ptr = std::unique_ptr<std::FILE, file_closer>;
+
+   inline file_ptr open_file(const std::string& path, const char* mode)
+   {
+      file_ptr f(std::fopen(path.c_str(), mode));
+      if(!f) detail::throw_io_error("cannot open " + path);
+      return f;
+   }
+
+   // Closes f, reporting what a failed final flush would otherwise hide
+   inline void close_file(file_ptr f, const std::string& path)
+   {
+      if(std::fclose(f.release()) != 0)
+         detail::throw_io_error("cannot write " + path);
+   }
+
+   // Reads up to count records; fewer only at the end of the file
+   inline std::size_t read_records(std::FILE* f,
+                                   unsigned char* data,
+                                   std::size_t record_size,
+                                   std::size_t count)
+   {
+      const auto bytes = std::fread(data, 1, record_size * count, f);
+      if(std::ferror(f)) detail::throw_io_error("read failed");
+      if(bytes % record_size != 0)
+         throw std::invalid_argument(
+             "external_sort: input is not a whole number of records");
+      return bytes / record_size;
+   }
+
+   inline void
+   write_bytes(std::FILE* f, const unsigned char* data, std::size_t bytes)
+   {
+      if(std::fwrite(data, 1, bytes, f) != bytes)
+         detail::throw_io_error("write failed");
+   }
+
+   // Flushes f, reporting a buffered write that failed (say, for want of
+   // disk space), which rewind would clear without a word
+   inline void flush_file(std::FILE* f)
+   {
+      if(std::fflush(f) != 0 or std::ferror(f))
+         detail::throw_io_error("write failed");
+   }
+
+   // A file for one run, deleted when this goes away
+   class temporary_file
+   {
+    public:
+      explicit temporary_file(const std::string& dir)
+      {
+         if(dir.empty()) {
+            file_.reset(std::tmpfile());
+            if(!file_)
+               detail::throw_io_error("cannot create a temporary file");
+            return;
+         }
+
+         std::random_device rd;
+         for(int i = 0; !file_; ++i) {
+            path_ = dir + "/learn_std-external-sort-" + std::to_string(rd())
+                    + std::to_string(rd());
+            file_.reset(std::fopen(path_.c_str(), "w+bx"));
+            if(!file_ and (errno != EEXIST
+                           or i + 1 == k_external_temporary_file_tries)) {
+               path_.clear();
+               detail::throw_io_error("cannot create a file in " + dir);
+            }
+         }
+      }
+
+      temporary_file(temporary_file&& o) noexcept
+          : path_(std::move(o.path_))
+          , file_(std::move(o.file_))
+      {
+         o.path_.clear();
+      }
+      temporary_file& operator=(temporary_file&&) = delete;
+
+      ~temporary_file()
+      {
+         file_.reset();
+         if(!path_.empty()) std::remove(path_.c_str());
+      }
+
+      std::FILE* get() const noexcept { return file_.get(); }
+
+    private:
+      std::string path_;
+      file_ptr file_;
+   };
+
+   // Reads a file of records a block at a time. The next block is read on
+   // another thread while the current one is in use.
+   class block_reader
+   {
+    public:
+      block_reader(std::FILE* f,
+                   std::size_t record_size,
+                   std::size_t block_records)
+          : f_(f)
+          , record_size_(record_size)
+          , block_records_(block_records)
+          , current_(record_size * block_records)
+          , next_(record_size * block_records)
+      {
+         fetch();
+         next_block();
+      }
+
+      bool done() const noexcept { return pos_ == end_; }
+      const unsigned char* record() const noexcept
+      {
+         return current_.data() + pos_;
+      }
+
+      void advance()
+      {
+         pos_ += record_size_;
+         if(pos_ == end_) next_block();
+      }
+
+    private:
+      void fetch()
+      {
+         pending_ = std::async(std::launch::async,
+                               [f     = f_,
+                                data  = next_.data(),
+                                size  = record_size_,
+                                count = block_records_]() {
+                                  return detail::read_records(
+                                      f, data, size, count);
+                               });
+      }
+
+      void next_block()
+      {
+         if(!pending_.valid()) return; // the file is exhausted
+         const auto n = pending_.get();
+         std::swap(current_, next_);
+         pos_ = 0;
+         end_ = n * record_size_;
+         if(n == block_records_) fetch();
+      }
+
+      std::FILE* f_;
+      std::size_t record_size_;
+      std::size_t block_records_;
+      std::vector<unsigned char> current_;
+      std::vector<unsigned char> next_;
+      std::size_t pos_ = 0;
+      std::size_t end_ = 0;
+      std::future<std::size_t> pending_;
+   };
+
+   // Writes records a block at a time. A full block is written on another
+   // thread while the next one fills.
+   class block_writer
+   {
+    public:
+      block_writer(std::FILE* f,
+                   std::size_t record_size,
+                   std::size_t block_records)
+          : f_(f)
+          , record_size_(record_size)
+          , current_(record_size * block_records)
+          , next_(record_size * block_records)
+      {}
+
+      void write(const unsigned char* record)
+      {
+         std::memcpy(current_.data() + used_, record, record_size_);
+         used_ += record_size_;
+         if(used_ == current_.size()) flush();
+      }
+
+      // Writes out what is buffered and waits for it
+      void finish()
+      {
+         flush();
+         pending_.get();
+      }
+
+    private:
+      void flush()
+      {
+         if(pending_.valid()) pending_.get();
+         pending_ = std::async(
+             std::launch::async,
+             [f = f_, data = current_.data(), bytes = used_]() {
+                detail::write_bytes(f, data, bytes);
+             });
+         std::swap(current_, next_);
+         used_ = 0;
+      }
+
+      std::FILE* f_;
+      std::size_t record_size_;
+      std::vector<unsigned char> current_;
+      std::vector<unsigned char> next_;
+      std::size_t used_ = 0;
+      std::future<void> pending_;
+   };
+
+   template<class Less>
+   void
+   merge_runs(std::vector<block_reader>& runs, block_writer& out, Less less)
+   {
+      // A loser tree over the runs: exhausted runs lose every match, and
+      // ties go to the earlier run, which keeps the merge stable
+      auto tree = detail::make_loser_tree(runs.size(), [&](auto a, auto b) {
+         if(runs[a].done()) return false;
+         if(runs[b].done()) return true;
+         return a < b ? !less(runs[b].record(), runs[a].record())
+                      : less(runs[a].record(), runs[b].record());
+      });
+
+      while(!runs[tree.winner()].done()) {
+         auto& run = runs[tree.winner()];
+         out.write(run.record());
+         run.advance();
+         tree.replay();
+      }
+   }
+
+   // Sorts count records at data by sorting their indices, then moves each
+   // record into place by following the permutation's cycles
+   template<class Less>
+   void sort_records(unsigned char* data,
+                     std::size_t count,
+                     std::size_t record_size,
+                     Less less)
+   {
+      std::vector<std::size_t> order(count);
+      std::iota(begin(order), end(order), std::size_t(0));
+      learn_std::pdq_sort(begin(order), end(order), [&](auto a, auto b) {
+         return less(data + a * record_size, data + b * record_size);
+      });
+
+      std::vector<unsigned char> held(record_size);
+      for(std::size_t i = 0; i < count; ++i) {
+         if(order[i] == i) continue;
+         std::memcpy(held.data(), data + i * record_size, record_size);
+         auto j = i;
+         while(order[j] != i) {
+            const auto k = order[j];
+            std::memcpy(
+                data + j * record_size, data + k * record_size, record_size);
+            order[j] = j;
+            j        = k;
+         }
+         std::memcpy(data + j * record_size, held.data(), record_size);
+         order[j] = j;
+      }
+   }
+
+   // read(data, n) fills data with up to n records, fewer only at the end.
+   // sort_run(data, n) sorts n records in place, using up to overhead bytes
+   // per record on the side.
+   template<class Read, class SortRun, class Less>
+   void external_sort(Read read,
+                      const std::string& out_path,
+                      std::size_t record_size,
+                      SortRun sort_run,
+                      std::size_t overhead,
+                      Less less,
+                      std::size_t mem_budget,
+                      const std::string& tmp_dir)
+   {
+      if(record_size == 0)
+         throw std::invalid_argument("external_sort: record_size is 0");
+      const auto chunk_records = mem_budget / (record_size + overhead);
+      if(mem_budget / 6 < record_size or chunk_records < 2)
+         throw std::invalid_argument("external_sort: mem_budget is too small");
+
+      // Every run being merged, and the output, get two blocks
+      auto block_records = [&](std::size_t fan_in) {
+         return mem_budget / (2 * (fan_in + 1) * record_size);
+      };
+      auto fan_in = std::clamp(mem_budget / (2 * k_external_min_block),
+                               std::size_t(3),
+                               k_external_max_fan_in + 1)
+                    - 1;
+      while(fan_in > 2 and block_records(fan_in) == 0) --fan_in;
+      const auto block = block_records(fan_in);
+
+      // Merges the runs [first, last) into f
+      auto merge_into = [&](auto first, auto last, std::FILE* f) {
+         std::vector<block_reader> readers;
+         for(auto run = first; run != last; ++run) {
+            detail::flush_file(run->get());
+            std::rewind(run->get());
+            readers.emplace_back(run->get(), record_size, block);
+         }
+         block_writer writer(f, record_size, block);
+         detail::merge_runs(readers, writer, less);
+         writer.finish();
+      };
+
+      // Runs, merged fan_in at a time as soon as there are that many of a
+      // level, so that open files grow with the number of levels
+      std::vector<std::vector<temporary_file>> levels(1);
+      {
+         bool spilled = false;
+         std::vector<unsigned char> chunk;
+         while(true) {
+            chunk.resize(chunk_records * record_size);
+            const auto n = read(chunk.data(), chunk_records);
+            if(n == 0 and spilled) break;
+            sort_run(chunk.data(), n);
+            if(!spilled and n < chunk_records) { // it all fit
+               auto out = detail::open_file(out_path, "wb");
+               detail::write_bytes(out.get(), chunk.data(), n * record_size);
+               detail::close_file(std::move(out), out_path);
+               return;
+            }
+            spilled = true;
+            levels[0].emplace_back(tmp_dir);
+            detail::write_bytes(
+                levels[0].back().get(), chunk.data(), n * record_size);
+
+            if(levels[0].size() == fan_in) {
+               std::vector<unsigned char>().swap(chunk); // the merge's now
+               for(std::size_t l = 0;
+                   l < levels.size() and levels[l].size() == fan_in;
+                   ++l) {
+                  if(l + 1 == levels.size()) levels.emplace_back();
+                  auto& level = levels[l];
+                  auto& next  = levels[l + 1];
+                  next.emplace_back(tmp_dir);
+                  merge_into(begin(level), end(level), next.back().get());
+                  level.clear();
+               }
+            }
+            if(n < chunk_records) break;
+         }
+      }
+
+      // What is left, smallest runs first, is merged down to fan_in runs,
+      // and those into the output
+      std::deque<temporary_file> runs;
+      for(auto& level : levels)
+         for(auto& run : level) runs.push_back(std::move(run));
+      levels.clear();
+      while(runs.size() > fan_in) {
+         const auto k = std::min(fan_in, runs.size() - fan_in + 1);
+         temporary_file merged(tmp_dir);
+         merge_into(begin(runs), begin(runs) + std::ptrdiff_t(k), merged.get());
+         for(std::size_t i = 0; i < k; ++i) runs.pop_front();
+         runs.push_back(std::move(merged));
+      }
+      auto out = detail::open_file(out_path, "wb");
+      merge_into(begin(runs), end(runs), out.get());
+      detail::close_file(std::move(out), out_path);
+   }
+
+   // Reads records out of [data, data + size)
+   inline auto memory_reader(const void* data,
+                             std::size_t size,
+                             std::size_t record_size)
+   {
+      if(record_size != 0 and size % record_size != 0)
+         throw std::invalid_argument(
+             "external_sort: input is not a whole number of records");
+      return [at   = static_cast<const unsigned char*>(data),
+              left = record_size == 0 ? 0 : size / record_size,
+              record_size](unsigned char* out, std::size_t n) mutable {
+         n = std::min(n, left);
+         if(n != 0) std::memcpy(out, at, n * record_size);
+         at += n * record_size;
+         left -= n;
+         return n;
+      };
+   }
+
+   template<class T> void check_external_record()
+   {
+      static_assert(std::is_trivially_copyable_v<T>,
+                    "external_sort requires trivially copyable records");
+      static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                    "external_sort does not support over-aligned records");
+   }
+
+   template<class T, class Compare> auto record_less(Compare& comp)
+   {
+      return [&comp](const unsigned char* a, const unsigned char* b) {
+         return comp(*reinterpret_cast<const T*>(a),
+                     *reinterpret_cast<const T*>(b));
+      };
+   }
+
+   template<class T, class Compare> auto typed_sort_run(Compare& comp)
+   {
+      return [&comp](unsigned char* data, std::size_t n) {
+         auto first = reinterpret_cast<T*>(data);
+         learn_std::pdq_sort(first, first + n, comp);
+      };
+   }
+} // namespace detail
+
+template<class Compare>
+void external_sort(const std::string& in_path,
+                   const std::string& out_path,
+                   std::size_t record_size,
+                   Compare comp,
+                   std::size_t mem_budget,
+                   const std::string& tmp_dir = "")
+{
+   auto in   = detail::open_file(in_path, "rb");
+   auto read = [&](unsigned char* data, std::size_t n) {
+      return detail::read_records(in.get(), data, record_size, n);
+   };
+   auto sort_run = [&](unsigned char* data, std::size_t n) {
+      detail::sort_records(data, n, record_size, comp);
+   };
+   detail::external_sort(read,
+                         out_path,
+                         record_size,
+                         sort_run,
+                         sizeof(std::size_t),
+                         comp,
+                         mem_budget,
+                         tmp_dir);
+}
+
+template<class Compare>
+void external_sort(const void* data,
+                   std::size_t size,
+                   const std::string& out_path,
+                   std::size_t record_size,
+                   Compare comp,
+                   std::size_t mem_budget,
+                   const std::string& tmp_dir = "")
+{
+   auto sort_run = [&](unsigned char* records, std::size_t n) {
+      detail::sort_records(records, n, record_size, comp);
+   };
+   detail::external_sort(detail::memory_reader(data, size, record_size),
+                         out_path,
+                         record_size,
+                         sort_run,
+                         sizeof(std::size_t),
+                         comp,
+                         mem_budget,
+                         tmp_dir);
+}
+
+template<class T, class Compare>
+void external_sort(const std::string& in_path,
+                   const std::string& out_path,
+                   Compare comp,
+                   std::size_t mem_budget,
+                   const std::string& tmp_dir = "")
+{
+   detail::check_external_record<T>();
+   auto in   = detail::open_file(in_path, "rb");
+   auto read = [&](unsigned char* data, std::size_t n) {
+      return detail::read_records(in.get(), data, sizeof(T), n);
+   };
+   detail::external_sort(read,
+                         out_path,
+                         sizeof(T),
+                         detail::typed_sort_run<T>(comp),
+                         0,
+                         detail::record_less<T>(comp),
+                         mem_budget,
+                         tmp_dir);
+}
+
+template<class T, class Compare>
+void external_sort(const T* first,
+                   const T* last,
+                   const std::string& out_path,
+                   Compare comp,
+                   std::size_t mem_budget,
+                   const std::string& tmp_dir = "")
+{
+   detail::check_external_record<T>();
+   detail::external_sort(
+       detail::memory_reader(
+           first, std::size_t(last - first) * sizeof(T), sizeof(T)),
+       out_path,
+       sizeof(T),
+       detail::typed_sort_run<T>(comp),
+       0,
+       detail::record_less<T>(comp),
+       mem_budget,
+       tmp_dir);
+}
+
+} // namespace learn_std
@@ -3,6 +3,7 @@
 
 #include <iterator>
 #include <random>
+#include <type_traits>
 #include <utility>
 
 // ------- Non-modifying sequence operations
@@ -62,7 +63,8 @@ constexpr BidirIt2 copy_backward(BidirIt1 first, BidirIt1 last, BidirIt2 d_last)
 template<class InputIt, class OutputIt>
 constexpr OutputIt move(InputIt first, InputIt last, OutputIt d_first)
 {
-   if(first == d_first) return last;
+   if constexpr(std::is_same_v<InputIt, OutputIt>)
+      if(first == d_first) return last;
    while(first != last) *d_first++ = std::move(*first++);
    return d_first;
 }
@@ -258,16 +260,24 @@ constexpr ForwardIt rotate(ForwardIt first, ForwardIt n_first, ForwardIt last)
    if(first == n_first) return last;
    if(n_first == last) return first;
 
-   auto read      = n_first;
-   auto write     = first;
-   auto next_read = first; // read position for when "read" hits "last"
-
-   while(read != last) {
-      if(write == next_read) next_read = read; // track where "first" went
-      learn_std::iter_swap(write++, read++);
+   // Each pass leaves what is left to rotate in [first, n_first, last). A
+   // loop rather than a recursive call: a lopsided rotation takes about as
+   // many passes as it has elements.
+   auto ret_value = last;
+   while(first != n_first and n_first != last) {
+      auto read      = n_first;
+      auto write     = first;
+      auto next_read = first; // read position for when "read" hits "last"
+
+      while(read != last) {
+         if(write == next_read) next_read = read; // track where "first" went
+         learn_std::iter_swap(write++, read++);
+      }
+      if(ret_value == last) ret_value = write;
+      first   = write;
+      n_first = next_read;
    }
-   learn_std::rotate(write, next_read, last);
-   return write;
+   return ret_value;
 }
 
 // return The iterator equal to first + (last - n_first)
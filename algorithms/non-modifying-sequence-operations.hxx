@@ -257,6 +257,7 @@ template<class ForwardIt, class BinaryPredicate>
 constexpr ForwardIt
 adjacent_find(ForwardIt first, ForwardIt last, BinaryPredicate p)
 {
+   if(first == last) return last;
    auto tail = next(first);
    while(tail != last) {
       if(p(*first, *tail)) return first;
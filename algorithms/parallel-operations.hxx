@@ -0,0 +1,702 @@
+#pragma once
+
+// ------- Parallel operations
+// execution policies: seq, par, par-unseq
+// sort
+// merge, inplace-merge
+// stable-sort
+// sample-sort
+// segmented-sort
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sorting-operations.hxx"
+
+namespace learn_std
+{
+// ----------------------------------------------------------- execution-policy
+// Tags in the style of C++17 <execution>. par_unseq runs the same code as
+// par: nothing here is vectorized across tasks. The parallel policies take
+// an optional thread count, e.g. execution::parallel_policy{8}; 0 means one
+// thread per hardware thread.
+namespace execution
+{
+   struct sequenced_policy
+   {};
+   struct parallel_policy
+   {
+      unsigned threads = 0;
+   };
+   struct parallel_unsequenced_policy
+   {
+      unsigned threads = 0;
+   };
+
+   inline constexpr sequenced_policy seq{};
+   inline constexpr parallel_policy par{};
+   inline constexpr parallel_unsequenced_policy par_unseq{};
+} // namespace execution
+
+template<class T> struct is_execution_policy : std::false_type
+{};
+template<>
+struct is_execution_policy<execution::sequenced_policy> : std::true_type
+{};
+template<>
+struct is_execution_policy<execution::parallel_policy> : std::true_type
+{};
+template<>
+struct is_execution_policy<execution::parallel_unsequenced_policy>
+    : std::true_type
+{};
+
+template<class T>
+inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+namespace detail
+{
+   template<class ExecutionPolicy, class T = void>
+   using enable_if_execution_policy_t = std::enable_if_t<
+       is_execution_policy_v<std::decay_t<ExecutionPolicy>>,
+       T>;
+
+   template<class ExecutionPolicy>
+   constexpr bool is_parallel_policy_v
+       = !std::is_same_v<std::decay_t<ExecutionPolicy>,
+                         execution::sequenced_policy>;
+
+   inline unsigned hardware_threads()
+   {
+      const auto n = std::thread::hardware_concurrency();
+      return n == 0 ? 1 : n;
+   }
+
+   template<class ExecutionPolicy>
+   unsigned policy_threads(const ExecutionPolicy& policy)
+   {
+      if constexpr(is_parallel_policy_v<ExecutionPolicy>)
+         return policy.threads == 0 ? hardware_threads() : policy.threads;
+      else
+         return 1;
+   }
+
+   // Runs f on another thread. The returned future rethrows anything f
+   // throws, and its destructor waits for f to finish.
+   template<class F> std::future<void> spawn(F&& f)
+   {
+      return std::async(std::launch::async, std::forward<F>(f));
+   }
+
+   // Calls f(t) for every t in [0, threads), each on its own thread. The
+   // calling thread runs f(0).
+   template<class F> void parallel_for_threads(unsigned threads, F f)
+   {
+      std::vector<std::future<void>> tasks;
+      tasks.reserve(threads);
+      for(unsigned t = 1; t < threads; ++t)
+         tasks.push_back(detail::spawn([&f, t]() { f(t); }));
+      f(0);
+      for(auto& task : tasks) task.get();
+   }
+
+   // [lo, hi) of the t-th of `parts` near-equal slices of [0, len)
+   template<class Size>
+   std::pair<Size, Size> chunk_bounds(Size len, unsigned parts, unsigned t)
+   {
+      return {len * t / parts, len * (t + 1) / parts};
+   }
+} // namespace detail
+
+// ------------------------------------------------------------------------ sort
+// Introsort whose partitions are sorted as parallel tasks. Threads are handed
+// down in proportion to the size of each side until every task has one
+// thread, which then runs the sequential introsort.
+namespace detail
+{
+   constexpr std::ptrdiff_t k_parallel_sort_grain = 1 << 14;
+
+   template<class RandomIt, class Compare>
+   void parallel_introsort(RandomIt first,
+                           RandomIt last,
+                           Compare comp,
+                           int depth_limit,
+                           unsigned threads)
+   {
+      if(threads < 2 or last - first <= k_parallel_sort_grain) {
+         detail::introsort_loop(first, last, depth_limit, comp);
+         detail::insertion_sort(first, last, comp);
+         return;
+      }
+
+      if(depth_limit-- == 0) {
+         detail::heap_sort(first, last, comp);
+         return;
+      }
+
+      detail::choose_pivot(first, last, comp);
+      auto mid = detail::partition_at_pivot(first, last, comp);
+
+      const auto l_len = mid - first;
+      const auto len   = last - first;
+      auto l_threads   = unsigned((threads * l_len + len / 2) / len);
+      l_threads        = std::clamp(l_threads, 1u, threads - 1);
+
+      auto task = detail::spawn([=]() {
+         detail::parallel_introsort(first, mid, comp, depth_limit, l_threads);
+      });
+      detail::parallel_introsort(
+          mid + 1, last, comp, depth_limit, threads - l_threads);
+      task.get();
+   }
+} // namespace detail
+
+template<class ExecutionPolicy, class RandomIt, class Compare>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+sort(ExecutionPolicy&& policy, RandomIt first, RandomIt last, Compare comp)
+{
+   if(last - first < 2) return;
+   detail::parallel_introsort(first,
+                              last,
+                              comp,
+                              2 * detail::floor_log2(last - first),
+                              detail::policy_threads(policy));
+}
+
+template<class ExecutionPolicy, class RandomIt>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+sort(ExecutionPolicy&& policy, RandomIt first, RandomIt last)
+{
+   learn_std::sort(
+       std::forward<ExecutionPolicy>(policy), first, last, std::less<>{});
+}
+
+// ----------------------------------------------------------------------- merge
+// Merge path partitioning (Odeh, Green, Mwassi, Shmueli and Birk): the output
+// is cut into one equal slice per thread, and a binary search along each
+// cut's diagonal finds how many of the elements before it come from each
+// input. Every thread then merges its own slice, with no synchronisation.
+// Ties go to the first range, as in merge, so the result is the same.
+namespace detail
+{
+   constexpr std::ptrdiff_t k_parallel_merge_grain = 1 << 15;
+
+   // How many of the first d elements of the stable merge of
+   // [first1, first1 + len1) and [first2, first2 + len2) come from the first
+   template<class RandomIt1, class RandomIt2, class Compare>
+   std::ptrdiff_t merge_path_split(RandomIt1 first1,
+                                   std::ptrdiff_t len1,
+                                   RandomIt2 first2,
+                                   std::ptrdiff_t len2,
+                                   std::ptrdiff_t d,
+                                   Compare comp)
+   {
+      auto lo = std::max<std::ptrdiff_t>(0, d - len2);
+      auto hi = std::min(d, len1);
+      while(lo < hi) {
+         const auto i = lo + (hi - lo) / 2;
+         if(comp(first2[d - i - 1], first1[i]))
+            hi = i;
+         else
+            lo = i + 1;
+      }
+      return lo;
+   }
+
+   // Splits the merge into one slice per thread, and calls
+   // merge_slice(i_lo, i_hi, j_lo, j_hi, d_lo) on each thread: the slice
+   // merges first1[i_lo, i_hi) and first2[j_lo, j_hi) into the output,
+   // starting d_lo elements in. Every split is found before any slice is
+   // merged, so merge_slice may move elements out of the inputs.
+   template<class RandomIt1, class RandomIt2, class Compare, class F>
+   void parallel_merge_slices(RandomIt1 first1,
+                              std::ptrdiff_t len1,
+                              RandomIt2 first2,
+                              std::ptrdiff_t len2,
+                              Compare comp,
+                              unsigned threads,
+                              F merge_slice)
+   {
+      const auto len = len1 + len2;
+      std::vector<std::ptrdiff_t> splits(threads + 1);
+      for(unsigned t = 0; t <= threads; ++t) {
+         const auto d = detail::chunk_bounds(len, threads, t).first;
+         splits[t]
+             = detail::merge_path_split(first1, len1, first2, len2, d, comp);
+      }
+
+      detail::parallel_for_threads(threads, [&](unsigned t) {
+         const auto [d_lo, d_hi] = detail::chunk_bounds(len, threads, t);
+         const auto i_lo         = splits[t];
+         const auto i_hi         = splits[t + 1];
+         merge_slice(i_lo, i_hi, d_lo - i_lo, d_hi - i_hi, d_lo);
+      });
+   }
+
+   // No more threads than slices of k_parallel_merge_grain elements
+   template<class ExecutionPolicy>
+   unsigned merge_threads(const ExecutionPolicy& policy, std::ptrdiff_t len)
+   {
+      const auto slices = std::max<std::ptrdiff_t>(
+          1, len / detail::k_parallel_merge_grain);
+      return unsigned(
+          std::min<std::ptrdiff_t>(detail::policy_threads(policy), slices));
+   }
+} // namespace detail
+
+template<class ExecutionPolicy,
+         class RandomIt1,
+         class RandomIt2,
+         class RandomIt3,
+         class Compare>
+detail::enable_if_execution_policy_t<ExecutionPolicy, RandomIt3>
+merge(ExecutionPolicy&& policy,
+      RandomIt1 first1,
+      RandomIt1 last1,
+      RandomIt2 first2,
+      RandomIt2 last2,
+      RandomIt3 d_first,
+      Compare comp)
+{
+   const std::ptrdiff_t len1 = last1 - first1;
+   const std::ptrdiff_t len2 = last2 - first2;
+   detail::parallel_merge_slices(
+       first1,
+       len1,
+       first2,
+       len2,
+       comp,
+       detail::merge_threads(policy, len1 + len2),
+       [&](auto i_lo, auto i_hi, auto j_lo, auto j_hi, auto d_lo) {
+          learn_std::merge(first1 + i_lo,
+                           first1 + i_hi,
+                           first2 + j_lo,
+                           first2 + j_hi,
+                           d_first + d_lo,
+                           comp);
+       });
+   return d_first + (len1 + len2);
+}
+
+template<class ExecutionPolicy,
+         class RandomIt1,
+         class RandomIt2,
+         class RandomIt3>
+detail::enable_if_execution_policy_t<ExecutionPolicy, RandomIt3>
+merge(ExecutionPolicy&& policy,
+      RandomIt1 first1,
+      RandomIt1 last1,
+      RandomIt2 first2,
+      RandomIt2 last2,
+      RandomIt3 d_first)
+{
+   return learn_std::merge(std::forward<ExecutionPolicy>(policy),
+                           first1,
+                           last1,
+                           first2,
+                           last2,
+                           d_first,
+                           std::less<>{});
+}
+
+// --------------------------------------------------------------- inplace-merge
+// Moves the range into a buffer, in parallel, and merges it back with the
+// parallel merge: 2n moves, all of them split between the threads. Falls
+// back to the sequential inplace_merge when a buffer for the whole range
+// can't be allocated.
+namespace detail
+{
+   // Merges [first, middle) and [middle, last) on up to `threads` threads,
+   // through buf: uninitialized storage for last - first elements
+   template<class RandomIt, class T, class Compare>
+   void parallel_buffered_merge(RandomIt first,
+                                RandomIt middle,
+                                RandomIt last,
+                                T* buf,
+                                Compare comp,
+                                unsigned threads)
+   {
+      const std::ptrdiff_t len1 = middle - first;
+      const std::ptrdiff_t len  = last - first;
+      if(len1 == 0 or len1 == len or !comp(*middle, *std::prev(middle)))
+         return;
+
+      // Destroys whichever slices of the buffer were moved into
+      std::vector<char> filled(threads);
+      struct destroy_slices
+      {
+         T* buf;
+         std::ptrdiff_t len;
+         const std::vector<char>& filled;
+         ~destroy_slices()
+         {
+            const auto threads = unsigned(filled.size());
+            for(unsigned t = 0; t < threads; ++t) {
+               const auto [lo, hi] = detail::chunk_bounds(len, threads, t);
+               if(filled[t]) std::destroy(buf + lo, buf + hi);
+            }
+         }
+      } cleanup{buf, len, filled};
+
+      detail::parallel_for_threads(threads, [&](unsigned t) {
+         const auto [lo, hi] = detail::chunk_bounds(len, threads, t);
+         std::uninitialized_move(first + lo, first + hi, buf + lo);
+         filled[t] = true;
+      });
+
+      detail::parallel_merge_slices(
+          buf,
+          len1,
+          buf + len1,
+          len - len1,
+          comp,
+          threads,
+          [&](auto i_lo, auto i_hi, auto j_lo, auto j_hi, auto d_lo) {
+             learn_std::move_merge(buf + i_lo,
+                                   buf + i_hi,
+                                   buf + len1 + j_lo,
+                                   buf + len1 + j_hi,
+                                   first + d_lo,
+                                   comp);
+          });
+   }
+} // namespace detail
+
+template<class ExecutionPolicy, class RandomIt, class Compare>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+inplace_merge(ExecutionPolicy&& policy,
+              RandomIt first,
+              RandomIt middle,
+              RandomIt last,
+              Compare comp)
+{
+   using T                  = detail::iter_value_t<RandomIt>;
+   const std::ptrdiff_t len = last - first;
+   const auto threads       = detail::merge_threads(policy, len);
+   if(threads < 2 or first == middle or middle == last
+      or !comp(*middle, *std::prev(middle))) {
+      learn_std::inplace_merge(first, middle, last, comp);
+      return;
+   }
+
+   detail::temporary_buffer<T> buffer(len);
+   if(buffer.size() < len)
+      learn_std::inplace_merge(first, middle, last, comp);
+   else
+      detail::parallel_buffered_merge(
+          first, middle, last, buffer.data(), comp, threads);
+}
+
+template<class ExecutionPolicy, class RandomIt>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+inplace_merge(ExecutionPolicy&& policy,
+              RandomIt first,
+              RandomIt middle,
+              RandomIt last)
+{
+   learn_std::inplace_merge(std::forward<ExecutionPolicy>(policy),
+                            first,
+                            middle,
+                            last,
+                            std::less<>{});
+}
+
+// ----------------------------------------------------------------- stable-sort
+// Each thread stable sorts one chunk, as the sequential stable_sort does,
+// and then neighbouring sorted chunks are merged pairwise, in log2(threads)
+// rounds. Every merge is split between all the threads by merge path.
+// scratch_budget caps the scratch space, in bytes: the chunk sorts share
+// it, and then the merges reuse it. A merge that doesn't fit runs on one
+// thread, galloping through what buffer there is, or as SymMerge with none,
+// so a tight budget costs the last, largest rounds their parallelism
+// rather than allocating more.
+template<class ExecutionPolicy, class RandomIt, class Compare>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+stable_sort(ExecutionPolicy&& policy,
+            RandomIt first,
+            RandomIt last,
+            Compare comp,
+            std::size_t scratch_budget)
+{
+   using T                = detail::iter_value_t<RandomIt>;
+   const std::ptrdiff_t n = last - first;
+   if(n < 2) return;
+   const auto scratch = std::ptrdiff_t(
+       std::min(scratch_budget / sizeof(T), std::size_t(n)));
+   const auto threads = unsigned(
+       std::clamp<std::ptrdiff_t>(n / detail::k_parallel_sort_grain,
+                                  1,
+                                  detail::policy_threads(policy)));
+
+   // Chunk t is [bounds[t], bounds[t + 1])
+   std::vector<std::ptrdiff_t> bounds(threads + 1);
+   for(unsigned t = 0; t <= threads; ++t)
+      bounds[t] = detail::chunk_bounds(n, threads, t).first;
+
+   detail::parallel_for_threads(threads, [&](unsigned t) {
+      const auto lo = first + bounds[t];
+      const auto hi = first + bounds[t + 1];
+      detail::temporary_buffer<T> buffer(
+          std::min<std::ptrdiff_t>((hi - lo) / 2, scratch / threads));
+      detail::powersort(lo, hi, comp, buffer);
+   });
+
+   detail::temporary_buffer<T> buffer(scratch);
+   std::ptrdiff_t min_gallop = detail::k_min_gallop;
+   while(bounds.size() > 2) {
+      std::vector<std::ptrdiff_t> merged{0};
+      std::size_t i = 0;
+      for(; i + 2 < bounds.size(); i += 2) {
+         const auto lo  = first + bounds[i];
+         const auto mid = first + bounds[i + 1];
+         const auto hi  = first + bounds[i + 2];
+         if(hi - lo <= buffer.size()) {
+            const auto merge_threads = detail::merge_threads(policy, hi - lo);
+            detail::parallel_buffered_merge(
+                lo, mid, hi, buffer.data(), comp, merge_threads);
+         } else {
+            detail::merge_adaptive(lo, mid, hi, comp, buffer, min_gallop);
+         }
+         merged.push_back(bounds[i + 2]);
+      }
+      if(i + 1 < bounds.size()) merged.push_back(bounds[i + 1]); // odd one out
+      bounds = std::move(merged);
+   }
+}
+
+template<class ExecutionPolicy, class RandomIt, class Compare>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+stable_sort(ExecutionPolicy&& policy,
+            RandomIt first,
+            RandomIt last,
+            Compare comp)
+{
+   learn_std::stable_sort(std::forward<ExecutionPolicy>(policy),
+                          first,
+                          last,
+                          comp,
+                          std::numeric_limits<std::size_t>::max());
+}
+
+template<class ExecutionPolicy, class RandomIt>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+stable_sort(ExecutionPolicy&& policy, RandomIt first, RandomIt last)
+{
+   learn_std::stable_sort(
+       std::forward<ExecutionPolicy>(policy), first, last, std::less<>{});
+}
+
+// ----------------------------------------------------------------- sample-sort
+// Parallel sample sort. Splitters come from a sorted random sample,
+// oversampled log2(n)/4 times per bucket. Elements are classified by
+// descending an implicit binary tree of splitters, one comparison per level
+// and no data-dependent branch. Each thread classifies and then scatters its
+// own slice, so the data moves once. Buckets are then sorted by whichever
+// thread is free. Types that are not default and copy constructible go to
+// the parallel sort instead.
+// A splitter that repeats is a key the sample is full of. The bucket after
+// it would be empty, so it takes the elements equal to the splitter
+// instead: one more comparison for each element classified next to it.
+// Such an equality bucket needs no sorting, and all the threads move it
+// home together, so that heavy duplicates don't leave one thread to do it.
+namespace detail
+{
+   constexpr int k_sample_sort_max_log_buckets = 8;
+
+   // Lays splitters [lo, hi) out as an implicit tree rooted at tree[i]
+   template<class T>
+   void build_splitter_tree(std::vector<T>& tree,
+                            const std::vector<T>& splitters,
+                            std::size_t lo,
+                            std::size_t hi,
+                            std::size_t i)
+   {
+      if(i >= tree.size()) return;
+      const auto mid = lo + (hi - lo) / 2;
+      tree[i]        = splitters[mid];
+      detail::build_splitter_tree(tree, splitters, lo, mid, 2 * i);
+      detail::build_splitter_tree(tree, splitters, mid + 1, hi, 2 * i + 1);
+   }
+} // namespace detail
+
+template<class RandomIt, class Compare>
+void sample_sort(RandomIt first, RandomIt last, Compare comp, unsigned threads)
+{
+   using T      = typename std::iterator_traits<RandomIt>::value_type;
+   const auto n = std::size_t(last - first);
+   if(threads == 0) threads = detail::hardware_threads();
+
+   if constexpr(!std::is_default_constructible_v<T>
+                or !std::is_copy_constructible_v<T>) {
+      learn_std::sort(
+          execution::parallel_policy{threads}, first, last, comp);
+   } else {
+      if(threads < 2 or n <= std::size_t(detail::k_parallel_sort_grain)) {
+         learn_std::sort(first, last, comp);
+         return;
+      }
+
+      int log_k = 1;
+      while((1u << log_k) < 4 * threads
+            and log_k < detail::k_sample_sort_max_log_buckets)
+         ++log_k;
+      const std::size_t k = std::size_t(1) << log_k;
+
+      // Splitters from an oversampled, sorted sample
+      const auto oversample
+          = std::size_t(std::max(1, detail::floor_log2(n) / 4));
+      std::vector<T> sample;
+      sample.reserve(k * oversample);
+      std::minstd_rand rng{unsigned(n)};
+      std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+      for(std::size_t i = 0; i < k * oversample; ++i)
+         sample.push_back(first[pick(rng)]);
+      learn_std::sort(sample.begin(), sample.end(), comp);
+
+      std::vector<T> splitters(k - 1);
+      for(std::size_t j = 0; j + 1 < k; ++j)
+         splitters[j] = sample[(j + 1) * oversample];
+      std::vector<T> tree(k); // tree[0] is unused
+      detail::build_splitter_tree(tree, splitters, 0, k - 1, 1);
+
+      // Buckets following a repeated splitter hold elements equal to it
+      std::vector<uint8_t> equal(k, 0);
+      bool has_equal = false;
+      for(std::size_t j = 0; j + 2 < k; ++j) {
+         equal[j + 1] = !comp(splitters[j], splitters[j + 1]);
+         has_equal |= equal[j + 1] != 0;
+      }
+
+      // Classify each thread's slice
+      std::vector<uint8_t> bucket_of(n);
+      std::vector<std::size_t> counts(threads * k, 0);
+      detail::parallel_for_threads(threads, [&](unsigned t) {
+         auto [lo, hi] = detail::chunk_bounds(n, threads, t);
+         auto* count   = &counts[t * k];
+         for(auto i = lo; i < hi; ++i) {
+            std::size_t j = 1;
+            for(int level = 0; level < log_k; ++level)
+               j = 2 * j + std::size_t(comp(tree[j], first[i]));
+            auto b = j - k;
+            if(has_equal and b + 1 < k)
+               b += equal[b + 1] & !comp(first[i], splitters[b]);
+            bucket_of[i] = uint8_t(b);
+            ++count[b];
+         }
+      });
+
+      // Where each thread writes into each bucket
+      std::vector<std::size_t> offsets(threads * k);
+      std::vector<std::size_t> bucket_begin(k + 1);
+      std::size_t sum = 0;
+      for(std::size_t b = 0; b < k; ++b) {
+         bucket_begin[b] = sum;
+         for(unsigned t = 0; t < threads; ++t) {
+            offsets[t * k + b] = sum;
+            sum += counts[t * k + b];
+         }
+      }
+      bucket_begin[k] = n;
+
+      std::vector<T> buffer(n);
+      detail::parallel_for_threads(threads, [&](unsigned t) {
+         auto [lo, hi] = detail::chunk_bounds(n, threads, t);
+         auto* offset  = &offsets[t * k];
+         for(auto i = lo; i < hi; ++i)
+            buffer[offset[bucket_of[i]]++] = std::move(first[i]);
+      });
+
+      // Sort buckets and move them home. Equality buckets are moved home
+      // by every thread, a share each.
+      std::atomic<std::size_t> next_bucket{0};
+      detail::parallel_for_threads(threads, [&](unsigned t) {
+         for(auto b = next_bucket++; b < k; b = next_bucket++) {
+            if(equal[b]) continue;
+            auto lo = buffer.begin() + bucket_begin[b];
+            auto hi = buffer.begin() + bucket_begin[b + 1];
+            learn_std::sort(lo, hi, comp);
+            learn_std::move(lo, hi, first + bucket_begin[b]);
+         }
+         for(std::size_t b = 0; b < k; ++b) {
+            if(!equal[b]) continue;
+            const auto len = bucket_begin[b + 1] - bucket_begin[b];
+            auto [lo, hi]  = detail::chunk_bounds(len, threads, t);
+            auto from      = buffer.begin() + bucket_begin[b];
+            learn_std::move(
+                from + lo, from + hi, first + bucket_begin[b] + lo);
+         }
+      });
+   }
+}
+
+template<class RandomIt, class Compare>
+void sample_sort(RandomIt first, RandomIt last, Compare comp)
+{
+   learn_std::sample_sort(first, last, comp, 0);
+}
+
+template<class RandomIt> void sample_sort(RandomIt first, RandomIt last)
+{
+   learn_std::sample_sort(first, last, std::less<>{}, 0);
+}
+
+// -------------------------------------------------------------- segmented-sort
+// The segments are bucketed as in the sequential segmented_sort. Every
+// thread sorts an equal share of each bucket of short segments, and then
+// takes long segments, longest first, until there are none left.
+template<class ExecutionPolicy,
+         class RandomIt,
+         class ForwardIt,
+         class Compare>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+segmented_sort(ExecutionPolicy&& policy,
+               RandomIt first,
+               RandomIt last,
+               ForwardIt offsets_first,
+               ForwardIt offsets_last,
+               Compare comp)
+{
+   auto buckets
+       = detail::bucket_segments(last - first, offsets_first, offsets_last);
+   auto& large = buckets.large;
+   learn_std::sort(begin(large), end(large), [](auto& a, auto& b) {
+      return a.second - a.first > b.second - b.first;
+   });
+
+   const auto threads = detail::policy_threads(policy);
+   std::atomic<std::size_t> next_large{0};
+   detail::parallel_for_threads(threads, [&](unsigned t) {
+      detail::sort_short_segments(first, buckets, comp, t, threads);
+      for(auto i = next_large++; i < large.size(); i = next_large++)
+         learn_std::sort(first + large[i].first, first + large[i].second, comp);
+   });
+}
+
+template<class ExecutionPolicy, class RandomIt, class ForwardIt>
+detail::enable_if_execution_policy_t<ExecutionPolicy>
+segmented_sort(ExecutionPolicy&& policy,
+               RandomIt first,
+               RandomIt last,
+               ForwardIt offsets_first,
+               ForwardIt offsets_last)
+{
+   learn_std::segmented_sort(std::forward<ExecutionPolicy>(policy),
+                             first,
+                             last,
+                             offsets_first,
+                             offsets_last,
+                             std::less<>{});
+}
+
+} // namespace learn_std
@@ -0,0 +1,865 @@
+
+#pragma once
+
+// ------- SIMD operations
+// simd-sort
+// simd-find-before
+//
+// Vectorized kernels for contiguous ranges of 32/64-bit integers, floats and
+// doubles. The instruction set (AVX-512, AVX2, or nothing) is read from CPUID
+// once at runtime, so the headers still build for any x86-64 target; other
+// architectures always report "not handled" and callers fall back to the
+// scalar algorithms.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "heap-operations.hxx"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define LEARN_STD_X86_SIMD 1
+#define LEARN_STD_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define LEARN_STD_TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+#define LEARN_STD_INLINE_AVX2 \
+   inline __attribute__((always_inline, target("avx2,popcnt")))
+#define LEARN_STD_INLINE_AVX512 \
+   inline __attribute__((always_inline, target("avx512f,popcnt")))
+#else
+#define LEARN_STD_X86_SIMD 0
+#endif
+
+namespace learn_std
+{
+// ------------------------------------------------------------------- simd-sort
+// Quicksort in the style of Bramas and of Intel's x86-simd-sort:
+//  * the partition loads one vector at a time from whichever end has less
+//    free space, and stores the "< pivot" lanes left and the rest right;
+//    AVX-512 does this with compress-store, AVX2 with a permute table
+//  * the min and max seen while partitioning tell when a side is empty or
+//    all equal to the pivot, so runs of duplicates finish in one pass
+//  * ranges of up to four vectors are sorted by a bitonic network in
+//    registers
+//  * too many bad pivots fall back to heapsort
+// Floats are only ever moved, never recomputed, so -0.0 and NaN payloads
+// survive; with NaNs the order is as unspecified as std::sort's.
+namespace detail
+{
+   template<class T>
+   struct is_simd_sortable
+       : std::bool_constant<std::is_arithmetic_v<T>
+                            and not std::is_same_v<T, bool>
+                            and (sizeof(T) == 4 or sizeof(T) == 8)>
+   {};
+
+   template<class Compare, class T> struct is_less_compare : std::false_type
+   {};
+   template<class T> struct is_less_compare<std::less<T>, T> : std::true_type
+   {};
+   template<class T> struct is_less_compare<std::less<>, T> : std::true_type
+   {};
+
+   template<class Compare, class T>
+   struct is_greater_compare : std::false_type
+   {};
+   template<class T>
+   struct is_greater_compare<std::greater<T>, T> : std::true_type
+   {};
+   template<class T>
+   struct is_greater_compare<std::greater<>, T> : std::true_type
+   {};
+
+   // C++17 has no contiguous iterator concept to ask, so recognize the
+   // iterators that matter: pointers and std::vector's, though not
+   // std::vector<bool>'s. Output iterators, such as back_insert_iterator,
+   // have a void value_type.
+   template<class It> struct is_contiguous_iterator
+   {
+      using value_type = typename std::iterator_traits<It>::value_type;
+      using vector     = std::vector<
+          std::conditional_t<std::is_void_v<value_type>, char, value_type>>;
+      static constexpr bool value
+          = std::is_pointer_v<It>
+            or (!std::is_same_v<value_type, bool>
+                and (std::is_same_v<It, typename vector::iterator>
+                     or std::is_same_v<It, typename vector::const_iterator>));
+   };
+
+   template<class RandomIt,
+            class Compare,
+            class T = typename std::iterator_traits<RandomIt>::value_type>
+   constexpr bool is_simd_sort_candidate_v
+       = std::conjunction_v<is_simd_sortable<T>,
+                            is_less_compare<Compare, T>,
+                            is_contiguous_iterator<RandomIt>>;
+
+   // Pads the sorting network: sorts after every real key
+   template<class T> constexpr T simd_sort_sentinel()
+   {
+      if constexpr(std::numeric_limits<T>::has_infinity)
+         return std::numeric_limits<T>::infinity();
+      else
+         return std::numeric_limits<T>::max();
+   }
+
+   // Median of nine evenly spaced keys
+   template<class T> T simd_sort_pivot(const T* first, const T* last)
+   {
+      const auto step = (last - first) / 9;
+      T s[9];
+      for(int i = 0; i < 9; ++i) {
+         auto x = first[i * step];
+         auto j = i;
+         for(; j > 0 and x < s[j - 1]; --j) s[j] = s[j - 1];
+         s[j] = x;
+      }
+      return s[4];
+   }
+
+#if LEARN_STD_X86_SIMD
+   enum class simd_isa { none, avx2, avx512 };
+
+   inline simd_isa simd_cpu_isa()
+   {
+      static const simd_isa isa = [] {
+         __builtin_cpu_init();
+         if(not __builtin_cpu_supports("popcnt")) return simd_isa::none;
+         if(__builtin_cpu_supports("avx512f")) return simd_isa::avx512;
+         if(__builtin_cpu_supports("avx2")) return simd_isa::avx2;
+         return simd_isa::none;
+      }();
+      return isa;
+   }
+
+   // ---------------------------------------------------------------- AVX2
+   // One nibble per destination 32-bit lane, giving the source lane of a
+   // permutation that moves elements whose mask bit is clear to the front
+   // and those whose bit is set to the back, each group in order.
+   template<int Lanes> struct avx2_compress_table
+   {
+      std::uint32_t index[1 << Lanes] = {};
+
+      constexpr avx2_compress_table()
+      {
+         constexpr int width = 8 / Lanes; // 32-bit lanes per element
+         for(unsigned m = 0; m < (1u << Lanes); ++m) {
+            int out = 0;
+            for(unsigned side = 0; side < 2; ++side)
+               for(int i = 0; i < Lanes; ++i)
+                  if(((m >> i) & 1u) == side)
+                     for(int w = 0; w < width; ++w, ++out)
+                        index[m] |= std::uint32_t(i * width + w) << (4 * out);
+         }
+      }
+   };
+
+   template<int Lanes>
+   inline constexpr avx2_compress_table<Lanes> k_avx2_compress{};
+
+   template<class T> struct avx2_ops
+   {
+      using vec                       = __m256i;
+      static constexpr int lanes      = int(32 / sizeof(T));
+      static constexpr unsigned all   = (1u << lanes) - 1;
+      static constexpr bool is_wide   = sizeof(T) == 8;
+      static constexpr bool is_float  = std::is_floating_point_v<T>;
+      static constexpr bool is_signed = std::is_signed_v<T>;
+
+      static LEARN_STD_INLINE_AVX2 vec load(const T* p)
+      {
+         return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      }
+
+      static LEARN_STD_INLINE_AVX2 void store(T* p, vec v)
+      {
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+      }
+
+      static LEARN_STD_INLINE_AVX2 vec set1(T x)
+      {
+         if constexpr(is_wide) {
+            std::int64_t bits;
+            std::memcpy(&bits, &x, sizeof(T));
+            return _mm256_set1_epi64x(bits);
+         } else {
+            std::int32_t bits;
+            std::memcpy(&bits, &x, sizeof(T));
+            return _mm256_set1_epi32(bits);
+         }
+      }
+
+      // All-ones lanes where a > b, integers only. AVX2 only has signed
+      // compares, so unsigned keys are biased by the sign bit first.
+      static LEARN_STD_INLINE_AVX2 vec gt(vec a, vec b)
+      {
+         if constexpr(is_wide) {
+            if constexpr(not is_signed) {
+               const auto bias = _mm256_set1_epi64x(
+                   std::numeric_limits<std::int64_t>::min());
+               a = _mm256_xor_si256(a, bias);
+               b = _mm256_xor_si256(b, bias);
+            }
+            return _mm256_cmpgt_epi64(a, b);
+         } else {
+            if constexpr(not is_signed) {
+               const auto bias = _mm256_set1_epi32(
+                   std::numeric_limits<std::int32_t>::min());
+               a = _mm256_xor_si256(a, bias);
+               b = _mm256_xor_si256(b, bias);
+            }
+            return _mm256_cmpgt_epi32(a, b);
+         }
+      }
+
+      // Bit i set where lane i of a < lane i of b
+      static LEARN_STD_INLINE_AVX2 unsigned lt(vec a, vec b)
+      {
+         if constexpr(is_float and is_wide)
+            return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(
+                _mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_LT_OQ)));
+         else if constexpr(is_float)
+            return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(
+                _mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_LT_OQ)));
+         else if constexpr(is_wide)
+            return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(gt(b, a))));
+         else
+            return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(gt(b, a))));
+      }
+
+      // Bit i set where lane i of v comes before bound: v < bound, or
+      // v > bound for std::greater
+      template<bool Greater>
+      static LEARN_STD_INLINE_AVX2 unsigned before(vec v, vec bound)
+      {
+         if constexpr(Greater)
+            return lt(bound, v);
+         else
+            return lt(v, bound);
+      }
+
+      static LEARN_STD_INLINE_AVX2 vec min(vec a, vec b)
+      {
+         if constexpr(is_float and is_wide)
+            return _mm256_castpd_si256(
+                _mm256_min_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+         else if constexpr(is_float)
+            return _mm256_castps_si256(
+                _mm256_min_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+         else if constexpr(is_wide)
+            return _mm256_blendv_epi8(a, b, gt(a, b));
+         else if constexpr(is_signed)
+            return _mm256_min_epi32(a, b);
+         else
+            return _mm256_min_epu32(a, b);
+      }
+
+      static LEARN_STD_INLINE_AVX2 vec max(vec a, vec b)
+      {
+         if constexpr(is_float and is_wide)
+            return _mm256_castpd_si256(
+                _mm256_max_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+         else if constexpr(is_float)
+            return _mm256_castps_si256(
+                _mm256_max_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+         else if constexpr(is_wide)
+            return _mm256_blendv_epi8(b, a, gt(a, b));
+         else if constexpr(is_signed)
+            return _mm256_max_epi32(a, b);
+         else
+            return _mm256_max_epu32(a, b);
+      }
+
+      // Lane i from b where bit i is set, else from a
+      static LEARN_STD_INLINE_AVX2 vec blend(vec a, vec b, unsigned bits)
+      {
+         vec bit, mask;
+         if constexpr(is_wide) {
+            bit  = _mm256_setr_epi64x(1, 2, 4, 8);
+            mask = _mm256_cmpeq_epi64(
+                _mm256_and_si256(_mm256_set1_epi64x(bits), bit), bit);
+         } else {
+            bit  = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            mask = _mm256_cmpeq_epi32(
+                _mm256_and_si256(_mm256_set1_epi32(int(bits)), bit), bit);
+         }
+         return _mm256_blendv_epi8(a, b, mask);
+      }
+
+      // Lane i takes lane i ^ j
+      static LEARN_STD_INLINE_AVX2 vec permute_xor(vec v, int j)
+      {
+         const auto lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+         const auto x    = _mm256_set1_epi32(is_wide ? 2 * j : j);
+         return _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(lane, x));
+      }
+
+      // Lanes with a clear bit first, then lanes with a set bit
+      static LEARN_STD_INLINE_AVX2 vec compress(vec v, unsigned bits)
+      {
+         const auto packed
+             = _mm256_set1_epi32(int(k_avx2_compress<lanes>.index[bits]));
+         const auto shift = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+         const auto index = _mm256_and_si256(_mm256_srlv_epi32(packed, shift),
+                                             _mm256_set1_epi32(15));
+         return _mm256_permutevar8x32_epi32(v, index);
+      }
+   };
+
+   // Partitions one vector into the free slots at store_lo and before
+   // store_hi. Both ends have at least a vector of free space, so AVX2 can
+   // store the whole permuted vector at each end. Keys equal to the pivot
+   // go to the back, or to the front if EqualLeft.
+   template<bool EqualLeft, class T>
+   LEARN_STD_INLINE_AVX2 void
+   avx2_partition_vec(typename avx2_ops<T>::vec v,
+                      typename avx2_ops<T>::vec pivot,
+                      T*& store_lo,
+                      T*& store_hi)
+   {
+      using ops     = avx2_ops<T>;
+      const auto hi = EqualLeft ? ops::lt(pivot, v)
+                                : ~ops::lt(v, pivot) & ops::all;
+      const auto n_hi = __builtin_popcount(hi);
+      const auto w    = ops::compress(v, hi);
+      ops::store(store_lo, w);
+      ops::store(store_hi - ops::lanes, w);
+      store_lo += ops::lanes - n_hi;
+      store_hi -= n_hi;
+   }
+
+   // [first, result) < pivot <= [result, last), or [first, result) <= pivot
+   // < [result, last) if EqualLeft; lo and hi receive the smallest and
+   // largest keys. Needs at least two vectors of keys.
+   template<bool EqualLeft, class T>
+   LEARN_STD_TARGET_AVX2 T*
+   avx2_partition(T* first, T* last, T pivot, T& lo, T& hi)
+   {
+      using ops = avx2_ops<T>;
+      lo = hi = pivot;
+
+      // Trim to a whole number of vectors
+      for(auto i = (last - first) % ops::lanes; i > 0; --i) {
+         if(*first < lo) lo = *first;
+         if(hi < *first) hi = *first;
+         if(EqualLeft ? !(pivot < *first) : *first < pivot)
+            ++first;
+         else
+            std::swap(*first, *--last);
+      }
+
+      const auto vpivot = ops::set1(pivot);
+      auto vlo          = vpivot;
+      auto vhi          = vpivot;
+      const auto head   = ops::load(first);
+      const auto tail   = ops::load(last - ops::lanes);
+      vlo               = ops::min(vlo, ops::min(head, tail));
+      vhi               = ops::max(vhi, ops::max(head, tail));
+
+      auto store_lo = first;
+      auto store_hi = last;
+      first += ops::lanes;
+      last -= ops::lanes;
+      while(first != last) {
+         typename ops::vec v;
+         if(store_hi - last < first - store_lo) {
+            last -= ops::lanes;
+            v = ops::load(last);
+         } else {
+            v = ops::load(first);
+            first += ops::lanes;
+         }
+         vlo = ops::min(vlo, v);
+         vhi = ops::max(vhi, v);
+         detail::avx2_partition_vec<EqualLeft>(v, vpivot, store_lo, store_hi);
+      }
+      detail::avx2_partition_vec<EqualLeft>(head, vpivot, store_lo, store_hi);
+      detail::avx2_partition_vec<EqualLeft>(tail, vpivot, store_lo, store_hi);
+
+      T keys[ops::lanes];
+      ops::store(keys, vlo);
+      for(auto x : keys)
+         if(x < lo) lo = x;
+      ops::store(keys, vhi);
+      for(auto x : keys)
+         if(hi < x) hi = x;
+      return store_lo;
+   }
+
+   // Bitonic network over four registers
+   template<class T>
+   LEARN_STD_TARGET_AVX2 void avx2_sort_small(T* first, T* last)
+   {
+      using ops       = avx2_ops<T>;
+      constexpr int L = ops::lanes;
+      constexpr int R = 4;
+
+      const auto n = last - first;
+      T keys[R * L];
+      std::memcpy(keys, first, std::size_t(n) * sizeof(T));
+      for(auto i = n; i < R * L; ++i) keys[i] = simd_sort_sentinel<T>();
+
+      typename ops::vec v[R];
+      for(int r = 0; r < R; ++r) v[r] = ops::load(keys + r * L);
+      for(int k = 2; k <= R * L; k *= 2) {
+         for(int j = k / 2; j > 0; j /= 2) {
+            for(int r = 0; r < R; ++r) {
+               if(j >= L) {
+                  const int p = r ^ (j / L);
+                  if(p < r) continue;
+                  auto& a = ((r * L) & k) ? v[p] : v[r];
+                  auto& b = ((r * L) & k) ? v[r] : v[p];
+                  const auto swap = ops::lt(b, a);
+                  const auto t    = ops::blend(a, b, swap);
+                  b               = ops::blend(b, a, swap);
+                  a               = t;
+               } else {
+                  unsigned to_max = 0;
+                  for(int i = 0; i < L; ++i) {
+                     const int g = r * L + i;
+                     if(bool(g & j) != bool(g & k)) to_max |= 1u << i;
+                  }
+                  const auto p    = ops::permute_xor(v[r], j);
+                  const auto swap = (ops::lt(v[r], p) & to_max)
+                                    | (ops::lt(p, v[r]) & ~to_max);
+                  v[r] = ops::blend(v[r], p, swap);
+               }
+            }
+         }
+      }
+      for(int r = 0; r < R; ++r) ops::store(keys + r * L, v[r]);
+      std::memcpy(first, keys, std::size_t(n) * sizeof(T));
+   }
+
+   // ------------------------------------------------------------- AVX-512
+   template<class T> struct avx512_ops
+   {
+      using vec                       = __m512i;
+      static constexpr int lanes      = int(64 / sizeof(T));
+      static constexpr unsigned all   = (1u << lanes) - 1;
+      static constexpr bool is_wide   = sizeof(T) == 8;
+      static constexpr bool is_float  = std::is_floating_point_v<T>;
+      static constexpr bool is_signed = std::is_signed_v<T>;
+
+      static LEARN_STD_INLINE_AVX512 vec load(const T* p)
+      {
+         return _mm512_loadu_si512(p);
+      }
+
+      static LEARN_STD_INLINE_AVX512 void store(T* p, vec v)
+      {
+         _mm512_storeu_si512(p, v);
+      }
+
+      static LEARN_STD_INLINE_AVX512 vec set1(T x)
+      {
+         if constexpr(is_wide) {
+            std::int64_t bits;
+            std::memcpy(&bits, &x, sizeof(T));
+            return _mm512_set1_epi64(bits);
+         } else {
+            std::int32_t bits;
+            std::memcpy(&bits, &x, sizeof(T));
+            return _mm512_set1_epi32(bits);
+         }
+      }
+
+      // Bit i set where lane i of a < lane i of b
+      static LEARN_STD_INLINE_AVX512 unsigned lt(vec a, vec b)
+      {
+         if constexpr(is_float and is_wide)
+            return _mm512_cmp_pd_mask(
+                _mm512_castsi512_pd(a), _mm512_castsi512_pd(b), _CMP_LT_OQ);
+         else if constexpr(is_float)
+            return _mm512_cmp_ps_mask(
+                _mm512_castsi512_ps(a), _mm512_castsi512_ps(b), _CMP_LT_OQ);
+         else if constexpr(is_wide and is_signed)
+            return _mm512_cmplt_epi64_mask(a, b);
+         else if constexpr(is_wide)
+            return _mm512_cmplt_epu64_mask(a, b);
+         else if constexpr(is_signed)
+            return _mm512_cmplt_epi32_mask(a, b);
+         else
+            return _mm512_cmplt_epu32_mask(a, b);
+      }
+
+      // Bit i set where lane i of v comes before bound: v < bound, or
+      // v > bound for std::greater
+      template<bool Greater>
+      static LEARN_STD_INLINE_AVX512 unsigned before(vec v, vec bound)
+      {
+         if constexpr(Greater)
+            return lt(bound, v);
+         else
+            return lt(v, bound);
+      }
+
+      static LEARN_STD_INLINE_AVX512 vec min(vec a, vec b)
+      {
+         if constexpr(is_float and is_wide)
+            return _mm512_castpd_si512(
+                _mm512_min_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b)));
+         else if constexpr(is_float)
+            return _mm512_castps_si512(
+                _mm512_min_ps(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b)));
+         else if constexpr(is_wide and is_signed)
+            return _mm512_min_epi64(a, b);
+         else if constexpr(is_wide)
+            return _mm512_min_epu64(a, b);
+         else if constexpr(is_signed)
+            return _mm512_min_epi32(a, b);
+         else
+            return _mm512_min_epu32(a, b);
+      }
+
+      static LEARN_STD_INLINE_AVX512 vec max(vec a, vec b)
+      {
+         if constexpr(is_float and is_wide)
+            return _mm512_castpd_si512(
+                _mm512_max_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b)));
+         else if constexpr(is_float)
+            return _mm512_castps_si512(
+                _mm512_max_ps(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b)));
+         else if constexpr(is_wide and is_signed)
+            return _mm512_max_epi64(a, b);
+         else if constexpr(is_wide)
+            return _mm512_max_epu64(a, b);
+         else if constexpr(is_signed)
+            return _mm512_max_epi32(a, b);
+         else
+            return _mm512_max_epu32(a, b);
+      }
+
+      // Lane i from b where bit i is set, else from a
+      static LEARN_STD_INLINE_AVX512 vec blend(vec a, vec b, unsigned bits)
+      {
+         if constexpr(is_wide)
+            return _mm512_mask_blend_epi64(__mmask8(bits), a, b);
+         else
+            return _mm512_mask_blend_epi32(__mmask16(bits), a, b);
+      }
+
+      // Lane i takes lane i ^ j
+      static LEARN_STD_INLINE_AVX512 vec permute_xor(vec v, int j)
+      {
+         if constexpr(is_wide) {
+            const auto lane = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+            return _mm512_permutexvar_epi64(
+                _mm512_xor_si512(lane, _mm512_set1_epi64(j)), v);
+         } else {
+            const auto lane = _mm512_setr_epi32(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            return _mm512_permutexvar_epi32(
+                _mm512_xor_si512(lane, _mm512_set1_epi32(j)), v);
+         }
+      }
+
+      // Stores just the lanes whose bit is set, contiguously
+      static LEARN_STD_INLINE_AVX512 void
+      compress_store(T* p, unsigned bits, vec v)
+      {
+         if constexpr(is_wide)
+            _mm512_mask_compressstoreu_epi64(p, __mmask8(bits), v);
+         else
+            _mm512_mask_compressstoreu_epi32(p, __mmask16(bits), v);
+      }
+   };
+
+   template<bool EqualLeft, class T>
+   LEARN_STD_INLINE_AVX512 void
+   avx512_partition_vec(typename avx512_ops<T>::vec v,
+                        typename avx512_ops<T>::vec pivot,
+                        T*& store_lo,
+                        T*& store_hi)
+   {
+      using ops     = avx512_ops<T>;
+      const auto hi = EqualLeft ? ops::lt(pivot, v)
+                                : ~ops::lt(v, pivot) & ops::all;
+      const auto n_hi = __builtin_popcount(hi);
+      ops::compress_store(store_lo, ~hi & ops::all, v);
+      ops::compress_store(store_hi - n_hi, hi, v);
+      store_lo += ops::lanes - n_hi;
+      store_hi -= n_hi;
+   }
+
+   // As avx2_partition
+   template<bool EqualLeft, class T>
+   LEARN_STD_TARGET_AVX512 T*
+   avx512_partition(T* first, T* last, T pivot, T& lo, T& hi)
+   {
+      using ops = avx512_ops<T>;
+      lo = hi = pivot;
+
+      for(auto i = (last - first) % ops::lanes; i > 0; --i) {
+         if(*first < lo) lo = *first;
+         if(hi < *first) hi = *first;
+         if(EqualLeft ? !(pivot < *first) : *first < pivot)
+            ++first;
+         else
+            std::swap(*first, *--last);
+      }
+
+      const auto vpivot = ops::set1(pivot);
+      auto vlo          = vpivot;
+      auto vhi          = vpivot;
+      const auto head   = ops::load(first);
+      const auto tail   = ops::load(last - ops::lanes);
+      vlo               = ops::min(vlo, ops::min(head, tail));
+      vhi               = ops::max(vhi, ops::max(head, tail));
+
+      auto store_lo = first;
+      auto store_hi = last;
+      first += ops::lanes;
+      last -= ops::lanes;
+      while(first != last) {
+         typename ops::vec v;
+         if(store_hi - last < first - store_lo) {
+            last -= ops::lanes;
+            v = ops::load(last);
+         } else {
+            v = ops::load(first);
+            first += ops::lanes;
+         }
+         vlo = ops::min(vlo, v);
+         vhi = ops::max(vhi, v);
+         detail::avx512_partition_vec<EqualLeft>(v, vpivot, store_lo, store_hi);
+      }
+      detail::avx512_partition_vec<EqualLeft>(head, vpivot, store_lo, store_hi);
+      detail::avx512_partition_vec<EqualLeft>(tail, vpivot, store_lo, store_hi);
+
+      T keys[ops::lanes];
+      ops::store(keys, vlo);
+      for(auto x : keys)
+         if(x < lo) lo = x;
+      ops::store(keys, vhi);
+      for(auto x : keys)
+         if(hi < x) hi = x;
+      return store_lo;
+   }
+
+   // As avx2_sort_small
+   template<class T>
+   LEARN_STD_TARGET_AVX512 void avx512_sort_small(T* first, T* last)
+   {
+      using ops       = avx512_ops<T>;
+      constexpr int L = ops::lanes;
+      constexpr int R = 4;
+
+      const auto n = last - first;
+      T keys[R * L];
+      std::memcpy(keys, first, std::size_t(n) * sizeof(T));
+      for(auto i = n; i < R * L; ++i) keys[i] = simd_sort_sentinel<T>();
+
+      typename ops::vec v[R];
+      for(int r = 0; r < R; ++r) v[r] = ops::load(keys + r * L);
+      for(int k = 2; k <= R * L; k *= 2) {
+         for(int j = k / 2; j > 0; j /= 2) {
+            for(int r = 0; r < R; ++r) {
+               if(j >= L) {
+                  const int p = r ^ (j / L);
+                  if(p < r) continue;
+                  auto& a = ((r * L) & k) ? v[p] : v[r];
+                  auto& b = ((r * L) & k) ? v[r] : v[p];
+                  const auto swap = ops::lt(b, a);
+                  const auto t    = ops::blend(a, b, swap);
+                  b               = ops::blend(b, a, swap);
+                  a               = t;
+               } else {
+                  unsigned to_max = 0;
+                  for(int i = 0; i < L; ++i) {
+                     const int g = r * L + i;
+                     if(bool(g & j) != bool(g & k)) to_max |= 1u << i;
+                  }
+                  const auto p    = ops::permute_xor(v[r], j);
+                  const auto swap = (ops::lt(v[r], p) & to_max)
+                                    | (ops::lt(p, v[r]) & ~to_max);
+                  v[r] = ops::blend(v[r], p, swap);
+               }
+            }
+         }
+      }
+      for(int r = 0; r < R; ++r) ops::store(keys + r * L, v[r]);
+      std::memcpy(first, keys, std::size_t(n) * sizeof(T));
+   }
+
+   // ------------------------------------------------------------- driver
+   template<simd_isa Isa, bool EqualLeft, class T>
+   T* simd_partition(T* first, T* last, T pivot, T& lo, T& hi)
+   {
+      if constexpr(Isa == simd_isa::avx512)
+         return detail::avx512_partition<EqualLeft>(first, last, pivot, lo, hi);
+      else
+         return detail::avx2_partition<EqualLeft>(first, last, pivot, lo, hi);
+   }
+
+   // When has_floor, no key in [first, last) is below floor. A pivot equal
+   // to it is the smallest key, so partitioning the usual way would leave
+   // the left side empty and the range as it was. Instead the keys equal to
+   // it are split off to the left, and are done, as pdq_sort's
+   // partition_left does.
+   template<simd_isa Isa, class T>
+   void simd_quicksort(T* first,
+                       T* last,
+                       int depth_limit,
+                       bool has_floor = false,
+                       T floor        = T())
+   {
+      constexpr std::ptrdiff_t vector_bytes
+          = Isa == simd_isa::avx512 ? 64 : 32;
+      constexpr std::ptrdiff_t small_size = 4 * vector_bytes / sizeof(T);
+
+      while(last - first > small_size) {
+         if(depth_limit-- == 0) {
+            learn_std::make_heap(first, last, std::less<>{});
+            learn_std::sort_heap(first, last, std::less<>{});
+            return;
+         }
+
+         const auto pivot = detail::simd_sort_pivot(first, last);
+         T lo, hi;
+         if(has_floor and !(floor < pivot)) {
+            first = detail::simd_partition<Isa, true>(
+                first, last, pivot, lo, hi);
+            continue;
+         }
+         const auto cut = detail::simd_partition<Isa, false>(
+             first, last, pivot, lo, hi);
+
+         // Nothing above the pivot: the range is all keys equal to it.
+         // Nothing below it: the next round splits off its equals.
+         const bool sort_hi = pivot < hi;
+         if(not(lo < pivot)) {
+            if(not sort_hi) return;
+            has_floor = true;
+            floor     = pivot;
+         } else if(cut - first < last - cut) {
+            detail::simd_quicksort<Isa>(
+                first, cut, depth_limit, has_floor, floor);
+            if(not sort_hi) return;
+            first     = cut;
+            has_floor = true;
+            floor     = pivot;
+         } else {
+            if(sort_hi)
+               detail::simd_quicksort<Isa>(cut, last, depth_limit, true, pivot);
+            last = cut;
+         }
+      }
+
+      if(last - first < 2) return;
+      if constexpr(Isa == simd_isa::avx512)
+         detail::avx512_sort_small(first, last);
+      else
+         detail::avx2_sort_small(first, last);
+   }
+
+   // Sorts [first, last) ascending and returns true, or returns false
+   // without touching the range when the CPU has neither AVX2 nor AVX-512.
+   template<class T> bool simd_sort(T* first, T* last)
+   {
+      static_assert(is_simd_sortable<T>::value);
+      int depth_limit = 0;
+      for(auto n = last - first; n > 1; n >>= 1) depth_limit += 2;
+
+      switch(simd_cpu_isa()) {
+      case simd_isa::avx512:
+         detail::simd_quicksort<simd_isa::avx512>(first, last, depth_limit);
+         return true;
+      case simd_isa::avx2:
+         detail::simd_quicksort<simd_isa::avx2>(first, last, depth_limit);
+         return true;
+      default: return false;
+      }
+   }
+#else
+   template<class T> bool simd_sort(T*, T*) { return false; }
+#endif
+} // namespace detail
+
+// ------------------------------------------------------------ simd-find-before
+// First key that comes before a bound under std::less or std::greater,
+// testing four vectors per branch. Made for filtering a stream against a
+// threshold that nearly every key fails.
+namespace detail
+{
+#if LEARN_STD_X86_SIMD
+   template<bool Greater, class T>
+   LEARN_STD_TARGET_AVX2 const T*
+   avx2_find_before(const T* first, const T* last, T bound)
+   {
+      using ops         = avx2_ops<T>;
+      constexpr auto L  = ops::lanes;
+      const auto vbound = ops::set1(bound);
+
+      for(; last - first >= 4 * L; first += 4 * L) {
+         unsigned any = 0;
+         for(int i = 0; i < 4; ++i)
+            any |= ops::template before<Greater>(ops::load(first + i * L),
+                                                 vbound);
+         if(any != 0) break;
+      }
+      for(; last - first >= L; first += L) {
+         const auto hits
+             = ops::template before<Greater>(ops::load(first), vbound);
+         if(hits != 0) return first + __builtin_ctz(hits);
+      }
+      for(; first != last; ++first)
+         if(Greater ? bound < *first : *first < bound) break;
+      return first;
+   }
+
+   template<bool Greater, class T>
+   LEARN_STD_TARGET_AVX512 const T*
+   avx512_find_before(const T* first, const T* last, T bound)
+   {
+      using ops         = avx512_ops<T>;
+      constexpr auto L  = ops::lanes;
+      const auto vbound = ops::set1(bound);
+
+      for(; last - first >= 4 * L; first += 4 * L) {
+         unsigned any = 0;
+         for(int i = 0; i < 4; ++i)
+            any |= ops::template before<Greater>(ops::load(first + i * L),
+                                                 vbound);
+         if(any != 0) break;
+      }
+      for(; last - first >= L; first += L) {
+         const auto hits
+             = ops::template before<Greater>(ops::load(first), vbound);
+         if(hits != 0) return first + __builtin_ctz(hits);
+      }
+      for(; first != last; ++first)
+         if(Greater ? bound < *first : *first < bound) break;
+      return first;
+   }
+#endif
+
+   template<class Compare, class T>
+   const T* simd_find_before(const T* first, const T* last, T bound)
+   {
+      static_assert(is_simd_sortable<T>::value);
+      constexpr bool greater = is_greater_compare<Compare, T>::value;
+      static_assert(greater or is_less_compare<Compare, T>::value);
+
+#if LEARN_STD_X86_SIMD
+      switch(simd_cpu_isa()) {
+      case simd_isa::avx512:
+         return detail::avx512_find_before<greater>(first, last, bound);
+      case simd_isa::avx2:
+         return detail::avx2_find_before<greater>(first, last, bound);
+      default: break;
+      }
+#endif
+      for(; first != last; ++first)
+         if(greater ? bound < *first : *first < bound) break;
+      return first;
+   }
+} // namespace detail
+
+} // namespace learn_std
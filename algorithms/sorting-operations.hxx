@@ -2,188 +2,2925 @@
 #pragma once
 
 // ------- Sorting operations
-// merge, inplace-merge
+// merge, move-merge, multiway-merge, inplace-merge
 // is-sorted, is-sorted-until
-// sort, stable-sort
+// sort, pdq-sort, sort-unique, stable-sort, block-stable-sort, sort-probe
+// sort-indices, stable-sort-indices
+// sort-by-key, stable-sort-by-key
+// segmented-sort
+// radix-sort, radix-sort-unique, msd-radix-sort, string-sort
 // nth-element
-// partial-sort, partial-sort-copy
+// partial-sort, partial-sort-copy, top-k
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "heap-operations.hxx"
 #include "modifying-sequence-operations.hxx"
 #include "non-modifying-sequence-operations.hxx"
 #include "partitioning-operations.hxx"
+#include "simd-operations.hxx"
+#include "zip-iterator.hxx"
 
 namespace learn_std
 {
 // ----------------------------------------------------------------------- merge
-// The standard function should use moves...
+// Stable: of two equal elements, the one from [first1, last1) goes first.
+// move_merge moves the elements instead of copying them.
+// Scalars (numbers and pointers) in contiguous memory take a branchless
+// loop: both heads are loaded, the comparison selects one to write, and its
+// input advances by the comparison's result, so that a hard to predict
+// order costs no mispredictions.
+// With random access inputs, once one input supplies k_min_gallop elements
+// in a row the merge gallops, as Timsort does: an exponential search finds
+// where the run ends, and the run is copied in bulk. Merging m elements
+// into n >> m then takes O(m log(n/m)) comparisons rather than O(n). Bulk
+// copies, and whatever is left over once an input runs out, go through one
+// memmove when the elements are trivially copyable and the output is
+// contiguous, and of the same value type, too.
+namespace detail
+{
+   // What to hold an element taken out of a range in. Not auto: *it may be
+   // a proxy, like zip_reference, that still refers into the range.
+   template<class It>
+   using iter_value_t = typename std::iterator_traits<It>::value_type;
+
+   template<class InputIt1, class InputIt2>
+   constexpr bool is_branchless_mergeable_v = std::conjunction_v<
+       std::is_same<iter_value_t<InputIt1>, iter_value_t<InputIt2>>,
+       std::is_scalar<iter_value_t<InputIt1>>,
+       is_contiguous_iterator<InputIt1>,
+       is_contiguous_iterator<InputIt2>>;
+
+   constexpr std::ptrdiff_t k_min_gallop = 7;
+
+   // First position in [first, last) where pred fails, for a partitioned
+   // range. Probes 1, 3, 7, 15... elements in before binary searching, so
+   // finding an answer k elements in costs O(log k) comparisons.
+   template<class BidirIt, class UnaryPredicate>
+   BidirIt gallop(BidirIt first, BidirIt last, UnaryPredicate pred)
+   {
+      const auto len = std::distance(first, last);
+      decltype(std::distance(first, last)) lo = 0;
+      decltype(std::distance(first, last)) hi = 1;
+      while(hi <= len and pred(*std::next(first, hi - 1))) {
+         lo = hi;
+         hi = 2 * hi + 1;
+      }
+      return learn_std::partition_point(
+          std::next(first, lo), std::next(first, std::min(hi, len)), pred);
+   }
+
+   template<class BidirIt, class T, class Compare>
+   BidirIt gallop_lower(BidirIt first, BidirIt last, const T& key, Compare comp)
+   {
+      return detail::gallop(
+          first, last, [&](const auto& x) { return comp(x, key); });
+   }
+
+   template<class BidirIt, class T, class Compare>
+   BidirIt gallop_upper(BidirIt first, BidirIt last, const T& key, Compare comp)
+   {
+      return detail::gallop(
+          first, last, [&](const auto& x) { return !comp(key, x); });
+   }
+
+   // Copies, or moves, [first, last) to d_first
+   template<bool Move, class InputIt, class OutputIt>
+   OutputIt merge_tail(InputIt first, InputIt last, OutputIt d_first)
+   {
+      using T = iter_value_t<InputIt>;
+      using U = iter_value_t<OutputIt>;
+      if constexpr(std::conjunction_v<std::is_trivially_copyable<T>,
+                                      std::is_same<std::remove_cv_t<T>, U>,
+                                      is_contiguous_iterator<InputIt>,
+                                      is_contiguous_iterator<OutputIt>>) {
+         const auto n = last - first;
+         if(n > 0)
+            std::memmove(std::addressof(*d_first),
+                         std::addressof(*first),
+                         std::size_t(n) * sizeof(T));
+         return d_first + n;
+      } else if constexpr(Move) {
+         return learn_std::move(first, last, d_first);
+      } else {
+         for(; first != last; ++first, ++d_first) *d_first = *first;
+         return d_first;
+      }
+   }
+
+   template<class It>
+   constexpr bool is_random_access_v = std::is_base_of_v<
+       std::random_access_iterator_tag,
+       typename std::iterator_traits<It>::iterator_category>;
+
+   template<bool Move,
+            class InputIt1,
+            class InputIt2,
+            class OutputIt,
+            class Compare>
+   OutputIt two_way_merge(InputIt1 first1,
+                          InputIt1 last1,
+                          InputIt2 first2,
+                          InputIt2 last2,
+                          OutputIt d_first,
+                          Compare comp)
+   {
+      constexpr bool gallops
+          = is_random_access_v<InputIt1> and is_random_access_v<InputIt2>;
+      std::ptrdiff_t min_gallop = k_min_gallop;
+
+      while(first1 != last1 and first2 != last2) {
+         // One element at a time; run1 and run2 count how many times in a
+         // row each input has won
+         std::ptrdiff_t run1 = 0;
+         std::ptrdiff_t run2 = 0;
+         if constexpr(is_branchless_mergeable_v<InputIt1, InputIt2>) {
+            while(first1 != last1 and first2 != last2
+                  and run1 + run2 < min_gallop) {
+               const auto a     = *first1;
+               const auto b     = *first2;
+               const bool take2 = comp(b, a);
+               *d_first++       = take2 ? b : a;
+               first1 += !take2;
+               first2 += take2;
+               run1 = (run1 + 1) * !take2;
+               run2 = (run2 + 1) * take2;
+            }
+         } else {
+            while(first1 != last1 and first2 != last2
+                  and (!gallops or run1 + run2 < min_gallop)) {
+               if(comp(*first2, *first1)) {
+                  if constexpr(Move)
+                     *d_first = std::move(*first2);
+                  else
+                     *d_first = *first2;
+                  ++first2;
+                  ++run2;
+                  run1 = 0;
+               } else {
+                  if constexpr(Move)
+                     *d_first = std::move(*first1);
+                  else
+                     *d_first = *first1;
+                  ++first1;
+                  ++run1;
+                  run2 = 0;
+               }
+               ++d_first;
+            }
+         }
+
+         // One input keeps winning: find where its run ends by galloping,
+         // and copy the whole run at once. Back to one at a time, and
+         // galloping made harder to get into, when the runs get short.
+         if constexpr(gallops) {
+            while(first1 != last1 and first2 != last2) {
+               const auto stop1
+                   = detail::gallop_upper(first1, last1, *first2, comp);
+               run1    = stop1 - first1;
+               d_first = detail::merge_tail<Move>(first1, stop1, d_first);
+               first1  = stop1;
+               if(first1 == last1) break;
+
+               const auto stop2
+                   = detail::gallop_lower(first2, last2, *first1, comp);
+               run2    = stop2 - first2;
+               d_first = detail::merge_tail<Move>(first2, stop2, d_first);
+               first2  = stop2;
+
+               min_gallop = std::max<std::ptrdiff_t>(1, min_gallop - 1);
+               if(run1 < k_min_gallop and run2 < k_min_gallop) {
+                  min_gallop += 2;
+                  break;
+               }
+            }
+         }
+      }
+
+      d_first = detail::merge_tail<Move>(first1, last1, d_first);
+      return detail::merge_tail<Move>(first2, last2, d_first);
+   }
+} // namespace detail
+
+template<class InputIt1, class InputIt2, class OutputIt, class Compare>
+OutputIt merge(InputIt1 first1,
+               InputIt1 last1,
+               InputIt2 first2,
+               InputIt2 last2,
+               OutputIt d_first,
+               Compare comp)
+{
+   return detail::two_way_merge<false>(
+       first1, last1, first2, last2, d_first, comp);
+}
+
+template<class InputIt1, class InputIt2, class OutputIt>
+OutputIt merge(InputIt1 first1,
+               InputIt1 last1,
+               InputIt2 first2,
+               InputIt2 last2,
+               OutputIt d_first)
+{
+   return learn_std::merge(
+       first1, last1, first2, last2, d_first, std::less<>{});
+}
+
 template<class InputIt1, class InputIt2, class OutputIt, class Compare>
-constexpr OutputIt merge(InputIt1 first1,
-                         InputIt1 last1,
-                         InputIt2 first2,
-                         InputIt2 last2,
-                         OutputIt d_first,
-                         Compare comp)
-{
-   while(first1 != last1 and first2 != last2)
-      if(comp(*first1, *first2))
-         *d_first++ = *first1++;
+OutputIt move_merge(InputIt1 first1,
+                    InputIt1 last1,
+                    InputIt2 first2,
+                    InputIt2 last2,
+                    OutputIt d_first,
+                    Compare comp)
+{
+   return detail::two_way_merge<true>(
+       first1, last1, first2, last2, d_first, comp);
+}
+
+template<class InputIt1, class InputIt2, class OutputIt>
+OutputIt move_merge(InputIt1 first1,
+                    InputIt1 last1,
+                    InputIt2 first2,
+                    InputIt2 last2,
+                    OutputIt d_first)
+{
+   return learn_std::move_merge(
+       first1, last1, first2, last2, d_first, std::less<>{});
+}
+
+// -------------------------------------------------------------- multiway-merge
+// Merges k sorted ranges into d_first. [ranges_begin, ranges_end) holds the
+// ranges, each a std::pair of iterators or anything with begin() and end().
+// The ranges may be single-pass: each element is read where it stands and
+// copied out once, so streams are merged lazily.
+// A loser tree picks the next element with ceil(log2 k) comparisons, where
+// a heap needs up to 2 log2 k and chained two-way merges touch every element
+// log2 k times. Equal elements come out in the order of their ranges, so
+// the merge is stable.
+namespace detail
+{
+   // Tournament tree over k sources. Each internal node keeps the loser of
+   // the match played there, so after the winner's source moves on, only the
+   // matches on the path from its leaf to the root are replayed.
+   // beats(a, b) is true when source a's current element goes before b's.
+   template<class Beats> class loser_tree
+   {
+    public:
+      loser_tree(std::size_t k, Beats beats)
+          : k_(k)
+          , beats_(beats)
+          , tree_(std::max<std::size_t>(k, 1))
+      {
+         if(k_ == 0) return;
+         // Leaves are nodes k..2k-1; node i plays the winners of 2i, 2i + 1
+         std::vector<std::size_t> winners(2 * k_);
+         for(std::size_t i = 0; i < k_; ++i) winners[k_ + i] = i;
+         for(auto i = k_ - 1; i > 0; --i) {
+            auto a = winners[2 * i];
+            auto b = winners[2 * i + 1];
+            if(beats_(b, a)) std::swap(a, b);
+            winners[i] = a;
+            tree_[i]   = b;
+         }
+         tree_[0] = winners[1];
+      }
+
+      std::size_t winner() const noexcept { return tree_[0]; }
+
+      // Call after the winner's source has moved to its next element
+      void replay()
+      {
+         auto w = tree_[0];
+         for(auto node = (k_ + w) / 2; node > 0; node /= 2)
+            if(beats_(tree_[node], w)) std::swap(tree_[node], w);
+         tree_[0] = w;
+      }
+
+    private:
+      std::size_t k_;
+      Beats beats_;
+      std::vector<std::size_t> tree_; // tree_[0] is the overall winner
+   };
+
+   template<class Beats>
+   loser_tree<Beats> make_loser_tree(std::size_t k, Beats beats)
+   {
+      return loser_tree<Beats>(k, beats);
+   }
+
+   template<class T> struct is_pair : std::false_type
+   {};
+   template<class T, class U> struct is_pair<std::pair<T, U>> : std::true_type
+   {};
+
+   template<class Range> auto range_begin(Range&& r)
+   {
+      using std::begin;
+      if constexpr(is_pair<std::decay_t<Range>>::value)
+         return r.first;
+      else
+         return begin(r);
+   }
+
+   template<class Range> auto range_end(Range&& r)
+   {
+      using std::end;
+      if constexpr(is_pair<std::decay_t<Range>>::value)
+         return r.second;
       else
-         *d_first++ = *first2++;
+         return end(r);
+   }
+} // namespace detail
+
+template<class InputIt, class OutputIt, class Compare>
+OutputIt multiway_merge(InputIt ranges_begin,
+                        InputIt ranges_end,
+                        OutputIt d_first,
+                        Compare comp)
+{
+   using It = decltype(detail::range_begin(*ranges_begin));
+
+   std::vector<std::pair<It, It>> cursors;
+   for(; ranges_begin != ranges_end; ++ranges_begin) {
+      auto&& range = *ranges_begin;
+      cursors.emplace_back(detail::range_begin(range),
+                           detail::range_end(range));
+   }
+   if(cursors.empty()) return d_first;
+
+   // Exhausted ranges lose every match; ties go to the earlier range
+   auto tree = detail::make_loser_tree(cursors.size(), [&](auto a, auto b) {
+      if(cursors[a].first == cursors[a].second) return false;
+      if(cursors[b].first == cursors[b].second) return true;
+      return a < b ? !comp(*cursors[b].first, *cursors[a].first)
+                   : comp(*cursors[a].first, *cursors[b].first);
+   });
+
+   while(true) {
+      auto& cursor = cursors[tree.winner()];
+      if(cursor.first == cursor.second) return d_first;
+      *d_first++ = *cursor.first;
+      ++cursor.first;
+      tree.replay();
+   }
+}
+
+template<class InputIt, class OutputIt>
+OutputIt
+multiway_merge(InputIt ranges_begin, InputIt ranges_end, OutputIt d_first)
+{
+   return learn_std::multiway_merge(
+       ranges_begin, ranges_end, d_first, std::less<>{});
+}
+
+// --------------------------------------------------------------- inplace-merge
+// Merges with a scratch buffer the size of the smaller side when one can be
+// allocated, galloping over long runs; with no buffer it degrades to
+// SymMerge. Same complexity as std::inplace_merge: O(n) comparisons with
+// the buffer, O(n log n) without.
+namespace detail
+{
+   // Uninitialized storage for up to size() elements. Settles for less when
+   // the full amount can't be allocated, so size() may be smaller than asked
+   // for, or 0.
+   template<class T> class temporary_buffer
+   {
+    public:
+      explicit temporary_buffer(std::ptrdiff_t n) noexcept
+      {
+         for(; n > 0; n /= 2) {
+            data_ = static_cast<T*>(::operator new(std::size_t(n) * sizeof(T),
+                                                   std::align_val_t(alignof(T)),
+                                                   std::nothrow));
+            if(data_ != nullptr) {
+               size_ = n;
+               break;
+            }
+         }
+      }
+
+      temporary_buffer(const temporary_buffer&) = delete;
+      temporary_buffer& operator=(const temporary_buffer&) = delete;
+
+      ~temporary_buffer()
+      {
+         if(data_ != nullptr)
+            ::operator delete(data_, std::align_val_t(alignof(T)));
+      }
+
+      T* data() const noexcept { return data_; }
+      std::ptrdiff_t size() const noexcept { return size_; }
+
+    private:
+      T* data_             = nullptr;
+      std::ptrdiff_t size_ = 0;
+   };
+
+   // Merges [first, mid) and [mid, last) after moving [first, mid) into buf.
+   // Starts one element at a time, and switches to galloping once one side
+   // wins min_gallop times in a row; min_gallop adapts across calls like
+   // Timsort's. Whatever way this exits, the rest of the buffered run is
+   // moved into the gap in front of the unmerged part of [mid, last).
+   template<class BidirIt, class T, class Compare>
+   void merge_lo(BidirIt first,
+                 BidirIt mid,
+                 BidirIt last,
+                 T* buf,
+                 Compare comp,
+                 std::ptrdiff_t& min_gallop)
+   {
+      T* a     = buf;
+      T* a_end = std::uninitialized_move(first, mid, buf);
+      auto b    = mid;
+      auto dest = first;
+
+      struct drain_buffer
+      {
+         T*& a;
+         T* a_end;
+         BidirIt& dest;
+         T* buf;
+         ~drain_buffer()
+         {
+            learn_std::move(a, a_end, dest);
+            std::destroy(buf, a_end);
+         }
+      } drain{a, a_end, dest, buf};
+
+      while(a != a_end and b != last) {
+         std::ptrdiff_t run_a = 0;
+         std::ptrdiff_t run_b = 0;
+         while(a != a_end and b != last
+               and std::max(run_a, run_b) < min_gallop) {
+            if(comp(*b, *a)) {
+               *dest++ = std::move(*b++);
+               ++run_b;
+               run_a = 0;
+            } else {
+               *dest++ = std::move(*a++);
+               ++run_a;
+               run_b = 0;
+            }
+         }
+
+         while(a != a_end and b != last) {
+            auto a_stop = detail::gallop_upper(a, a_end, *b, comp);
+            run_a       = a_stop - a;
+            dest        = detail::merge_tail<true>(a, a_stop, dest);
+            a           = a_stop;
+            if(a == a_end) break;
+
+            auto b_stop = detail::gallop_lower(b, last, *a, comp);
+            run_b       = std::distance(b, b_stop);
+            dest        = detail::merge_tail<true>(b, b_stop, dest);
+            b           = b_stop;
+
+            min_gallop = std::max<std::ptrdiff_t>(1, min_gallop - 1);
+            if(run_a < k_min_gallop and run_b < k_min_gallop) {
+               min_gallop += 2; // galloping isn't paying off
+               break;
+            }
+         }
+      }
+   }
+
+   // Stable merge of [first, mid) and [mid, last). Only the elements that
+   // actually move are merged: the prefix of [first, mid) that is not
+   // greater than *mid, and the suffix of [mid, last) that is not less than
+   // *(mid - 1), are already in place. The smaller side goes in the buffer;
+   // a right side is merged back to front through reverse iterators.
+   // When neither side fits in the buffer, the merge is split in two with
+   // one rotation, as in SymMerge (Kim and Kutzner), and each half tries
+   // again. With no buffer at all that is SymMerge: O(n log n) moves and
+   // O(m log(n/m + 1)) comparisons for sides of m <= n elements.
+   template<class BidirIt, class T, class Compare>
+   void merge_adaptive(BidirIt first,
+                       BidirIt mid,
+                       BidirIt last,
+                       Compare comp,
+                       temporary_buffer<T>& buffer,
+                       std::ptrdiff_t& min_gallop)
+   {
+      if(first == mid or mid == last) return;
+      const auto a_back = std::prev(mid);
+      if(!comp(*mid, *a_back)) return;
+
+      first = learn_std::partition_point(
+          first, mid, [&](const auto& x) { return !comp(*mid, x); });
+      last = learn_std::partition_point(
+          mid, last, [&](const auto& x) { return comp(x, *a_back); });
+
+      const auto len_a = std::distance(first, mid);
+      const auto len_b = std::distance(mid, last);
+      if(len_a == 1 or len_b == 1) {
+         // After trimming, a lone element moves past the whole other side
+         learn_std::rotate(first, mid, last);
+      } else if(std::min(len_a, len_b) <= buffer.size()) {
+         if(len_a <= len_b)
+            detail::merge_lo(first, mid, last, buffer.data(), comp, min_gallop);
+         else
+            detail::merge_lo(std::make_reverse_iterator(last),
+                             std::make_reverse_iterator(mid),
+                             std::make_reverse_iterator(first),
+                             buffer.data(),
+                             [&](const auto& x, const auto& y) {
+                                return comp(y, x);
+                             },
+                             min_gallop);
+      } else {
+         // Find the split [start, end) around the middle of the whole range
+         // such that rotating [start, mid, end) leaves two merges that
+         // meet at the middle.
+         const auto len  = len_a + len_b;
+         const auto half = len / 2;
+         const auto n    = half + len_a;
+         auto lo         = len_a > half ? n - len : decltype(len)(0);
+         auto hi         = len_a > half ? half : len_a;
+         while(lo < hi) {
+            const auto c = lo + (hi - lo) / 2;
+            if(!comp(*std::next(first, n - 1 - c), *std::next(first, c)))
+               lo = c + 1;
+            else
+               hi = c;
+         }
+
+         const auto start   = std::next(first, lo);
+         const auto end     = std::next(first, n - lo);
+         const auto new_mid = learn_std::rotate(start, mid, end);
+         detail::merge_adaptive(
+             first, start, new_mid, comp, buffer, min_gallop);
+         detail::merge_adaptive(new_mid, end, last, comp, buffer, min_gallop);
+      }
+   }
+} // namespace detail
+
+template<class BidirIt, class Compare>
+void inplace_merge(BidirIt first, BidirIt middle, BidirIt last, Compare comp)
+{
+   using T = typename std::iterator_traits<BidirIt>::value_type;
+   if(first == middle or middle == last) return;
+   if(!comp(*middle, *std::prev(middle))) return; // already in order
+
+   detail::temporary_buffer<T> buffer(
+       std::min(std::distance(first, middle), std::distance(middle, last)));
+   std::ptrdiff_t min_gallop = detail::k_min_gallop;
+   detail::merge_adaptive(first, middle, last, comp, buffer, min_gallop);
+}
+
+template<class BidirIt>
+void inplace_merge(BidirIt first, BidirIt middle, BidirIt last)
+{
+   learn_std::inplace_merge(first, middle, last, std::less<>{});
+}
+
+// -------------------------------------------------------------- is-sorted-util
+template<class ForwardIt, class Compare>
+constexpr ForwardIt
+is_sorted_until(ForwardIt first, ForwardIt last, Compare comp)
+{
+   auto ii = learn_std::adjacent_find(
+       first, last, [&](auto& a, auto& b) { return comp(b, a); });
+   return ii == last ? last : std::next(ii);
+}
+
+template<class ForwardIt>
+constexpr ForwardIt is_sorted_until(ForwardIt first, ForwardIt last)
+{
+   return learn_std::is_sorted_until(
+       first, last, [](auto& a, auto& b) { return a < b; });
+}
+
+// ------------------------------------------------------------------- is-sorted
+template<class ForwardIt, class Compare>
+constexpr bool is_sorted(ForwardIt first, ForwardIt last, Compare comp)
+{
+   return learn_std::is_sorted_until(first, last, comp) == last;
+}
+
+template<class ForwardIt>
+constexpr bool is_sorted(ForwardIt first, ForwardIt last)
+{
+   return learn_std::is_sorted(
+       first, last, [](auto& a, auto& b) { return a < b; });
+}
+
+// ------------------------------------------------------------------------ sort
+// Introsort:
+//  * median-of-3 pivot, ninther on large ranges
+//  * recurse into the smaller half and loop on the larger, so the stack
+//    depth is O(log n)
+//  * heapsort once the recursion exceeds 2 log2(n) levels, which bounds the
+//    worst case at O(n log n)
+//  * insertion-sort the small ranges that are left over
+// sort itself comes after the other engines it can choose, under
+// sort-probe.
+namespace detail
+{
+   constexpr std::ptrdiff_t k_insertion_sort_threshold = 16;
+   constexpr std::ptrdiff_t k_ninther_threshold        = 128;
+
+   template<class Size> constexpr int floor_log2(Size n)
+   {
+      int ret = 0;
+      while(n > 1) {
+         n /= 2;
+         ++ret;
+      }
+      return ret;
+   }
+
+   template<class RandomIt, class Compare>
+   constexpr void insertion_sort(RandomIt first, RandomIt last, Compare comp)
+   {
+      if(first == last) return;
+      for(auto ii = std::next(first); ii != last; ++ii) {
+         iter_value_t<RandomIt> value = std::move(*ii);
+         auto jj                      = ii;
+         for(; jj != first and comp(value, *std::prev(jj)); --jj)
+            *jj = std::move(*std::prev(jj));
+         *jj = std::move(value);
+      }
+   }
+
+   // Sorts *a, *b, *c
+   template<class RandomIt, class Compare>
+   constexpr void sort3(RandomIt a, RandomIt b, RandomIt c, Compare comp)
+   {
+      if(comp(*b, *a)) learn_std::iter_swap(a, b);
+      if(comp(*c, *b)) {
+         learn_std::iter_swap(b, c);
+         if(comp(*b, *a)) learn_std::iter_swap(a, b);
+      }
+   }
+
+   // Moves the chosen pivot to *first
+   template<class RandomIt, class Compare>
+   constexpr void choose_pivot(RandomIt first, RandomIt last, Compare comp)
+   {
+      auto len = last - first;
+      auto mid = first + len / 2;
+      if(len > k_ninther_threshold) {
+         detail::sort3(first, mid, last - 1, comp);
+         detail::sort3(first + 1, mid - 1, last - 2, comp);
+         detail::sort3(first + 2, mid + 1, last - 3, comp);
+         detail::sort3(mid - 1, mid, mid + 1, comp);
+      } else {
+         detail::sort3(first, mid, last - 1, comp);
+      }
+      learn_std::iter_swap(first, mid);
+   }
+
+   // Hoare partition around the pivot at *first. Both scans stop on
+   // elements equal to the pivot, so runs of equal keys split evenly.
+   // Returns the final position of the pivot.
+   template<class RandomIt, class Compare>
+   constexpr RandomIt
+   partition_at_pivot(RandomIt first, RandomIt last, Compare comp)
+   {
+      auto lo = first + 1;
+      auto hi = last - 1;
+      while(true) {
+         while(lo <= hi and comp(*lo, *first)) ++lo;
+         while(lo <= hi and comp(*first, *hi)) --hi;
+         if(lo >= hi) break;
+         learn_std::iter_swap(lo++, hi--);
+      }
+      learn_std::iter_swap(first, hi);
+      return hi;
+   }
+
+   template<class RandomIt, class Compare>
+   constexpr void heap_sort(RandomIt first, RandomIt last, Compare comp)
+   {
+      learn_std::make_heap(first, last, comp);
+      learn_std::sort_heap(first, last, comp);
+   }
+
+   template<class RandomIt, class Compare>
+   constexpr void
+   introsort_loop(RandomIt first, RandomIt last, int depth_limit, Compare comp)
+   {
+      while(last - first > k_insertion_sort_threshold) {
+         if(depth_limit-- == 0) {
+            detail::heap_sort(first, last, comp);
+            return;
+         }
+
+         detail::choose_pivot(first, last, comp);
+         auto mid = detail::partition_at_pivot(first, last, comp);
+
+         if(mid - first < last - mid) {
+            detail::introsort_loop(first, mid, depth_limit, comp);
+            first = mid + 1;
+         } else {
+            detail::introsort_loop(mid + 1, last, depth_limit, comp);
+            last = mid;
+         }
+      }
+   }
+
+   template<class RandomIt, class Compare>
+   constexpr void introsort(RandomIt first, RandomIt last, Compare comp)
+   {
+      if(last - first < 2) return;
+      detail::introsort_loop(
+          first, last, 2 * detail::floor_log2(last - first), comp);
+      detail::insertion_sort(first, last, comp);
+   }
+} // namespace detail
+
+// -------------------------------------------------------------------- pdq-sort
+// Pattern-defeating quicksort (Orson Peters):
+//  * sorted and reverse-sorted inputs finish in O(n)
+//  * a pivot equal to the element left of the range means there are many
+//    duplicates: equal keys go left in one pass and are never visited again
+//  * highly unbalanced splits shuffle a few elements to break up patterns,
+//    and too many of them fall back to heapsort
+//  * arithmetic keys with std::less/std::greater partition in blocks
+//    (BlockQuicksort, Edelkamp and Weiss), so no branch depends on a
+//    comparison result
+namespace detail
+{
+   template<class Compare> struct is_default_compare : std::false_type
+   {};
+   template<class T> struct is_default_compare<std::less<T>> : std::true_type
+   {};
+   template<class T>
+   struct is_default_compare<std::greater<T>> : std::true_type
+   {};
+
+   template<class RandomIt, class Compare>
+   constexpr bool is_branchless_sortable_v
+       = is_default_compare<Compare>::value and std::is_arithmetic_v<
+           typename std::iterator_traits<RandomIt>::value_type>;
+
+   constexpr std::ptrdiff_t k_partial_insertion_sort_limit = 8;
+   constexpr std::ptrdiff_t k_partition_block_size         = 64;
+
+   // Insertion sort that gives up after moving k_partial_insertion_sort_limit
+   // elements. Returns true iff [first, last) ended up sorted.
+   template<class RandomIt, class Compare>
+   bool partial_insertion_sort(RandomIt first, RandomIt last, Compare comp)
+   {
+      if(first == last) return true;
+      std::ptrdiff_t moved = 0;
+      for(auto ii = first + 1; ii != last; ++ii) {
+         if(comp(*ii, *(ii - 1))) {
+            iter_value_t<RandomIt> value = std::move(*ii);
+            auto jj                      = ii;
+            do {
+               *jj = std::move(*(jj - 1));
+               --jj;
+            } while(jj != first and comp(value, *(jj - 1)));
+            *jj = std::move(value);
+            moved += ii - jj;
+         }
+         if(moved > k_partial_insertion_sort_limit) return false;
+      }
+      return true;
+   }
+
+   // Reverses [first, last) if it is strictly descending. The scan stops at
+   // the first ascending pair, so random input pays for a couple of
+   // comparisons.
+   template<class RandomIt, class Compare>
+   bool reverse_if_descending(RandomIt first, RandomIt last, Compare comp)
+   {
+      for(auto ii = first + 1; ii != last; ++ii)
+         if(!comp(*ii, *(ii - 1))) return false;
+      learn_std::reverse(first, last);
+      return true;
+   }
+
+   // Partitions around the pivot at *first, putting elements equal to the
+   // pivot on the left. Used when the pivot compares equal to the element
+   // before the range, so nothing in the range is smaller than the pivot.
+   template<class RandomIt, class Compare>
+   RandomIt pdq_partition_left(RandomIt first, RandomIt last, Compare comp)
+   {
+      iter_value_t<RandomIt> pivot = std::move(*first);
+      auto lo                      = first;
+      auto hi                      = last;
+
+      while(comp(pivot, *--hi))
+         ;
+      if(hi + 1 == last)
+         while(lo < hi and !comp(pivot, *++lo))
+            ;
+      else
+         while(!comp(pivot, *++lo))
+            ;
+
+      while(lo < hi) {
+         learn_std::iter_swap(lo, hi);
+         while(comp(pivot, *--hi))
+            ;
+         while(!comp(pivot, *++lo))
+            ;
+      }
+
+      *first = std::move(*hi);
+      *hi    = std::move(pivot);
+      return hi;
+   }
+
+   // Partitions around the pivot at *first, putting elements equal to the
+   // pivot on the right. Returns the final position of the pivot, and
+   // whether the range was already partitioned.
+   template<class RandomIt, class Compare>
+   std::pair<RandomIt, bool>
+   pdq_partition_right(RandomIt first, RandomIt last, Compare comp)
+   {
+      iter_value_t<RandomIt> pivot = std::move(*first);
+      auto lo                      = first;
+      auto hi                      = last;
+
+      // choose_pivot leaves an element >= pivot at the end of the range
+      while(comp(*++lo, pivot))
+         ;
+      if(lo - 1 == first)
+         while(lo < hi and !comp(*--hi, pivot))
+            ;
+      else
+         while(!comp(*--hi, pivot))
+            ;
+
+      const bool already_partitioned = lo >= hi;
+      while(lo < hi) {
+         learn_std::iter_swap(lo, hi);
+         while(comp(*++lo, pivot))
+            ;
+         while(!comp(*--hi, pivot))
+            ;
+      }
+
+      auto pivot_pos = lo - 1;
+      *first         = std::move(*pivot_pos);
+      *pivot_pos     = std::move(pivot);
+      return {pivot_pos, already_partitioned};
+   }
+
+   // Swaps the misplaced elements recorded in two offset blocks. When the
+   // counts differ a cyclic permutation does it in n + 1 moves instead of
+   // 3n, but equal counts must really swap to keep descending input O(n).
+   template<class RandomIt>
+   void swap_offsets(RandomIt l_base,
+                     RandomIt r_base,
+                     const unsigned char* offsets_l,
+                     const unsigned char* offsets_r,
+                     std::ptrdiff_t n,
+                     bool use_swaps)
+   {
+      if(use_swaps) {
+         for(std::ptrdiff_t i = 0; i < n; ++i)
+            learn_std::iter_swap(l_base + offsets_l[i], r_base - offsets_r[i]);
+      } else if(n > 0) {
+         auto l                     = l_base + offsets_l[0];
+         auto r                     = r_base - offsets_r[0];
+         iter_value_t<RandomIt> tmp = std::move(*l);
+         *l                         = std::move(*r);
+         for(std::ptrdiff_t i = 1; i < n; ++i) {
+            l  = l_base + offsets_l[i];
+            *r = std::move(*l);
+            r  = r_base - offsets_r[i];
+            *l = std::move(*r);
+         }
+         *r = std::move(tmp);
+      }
+   }
+
+   // pdq_partition_right with branchless block partitioning. Offsets of
+   // elements on the wrong side are recorded by always writing the offset
+   // and advancing the write cursor by the comparison result.
+   template<class RandomIt, class Compare>
+   std::pair<RandomIt, bool>
+   pdq_partition_right_branchless(RandomIt first, RandomIt last, Compare comp)
+   {
+      constexpr auto block = k_partition_block_size;
+
+      iter_value_t<RandomIt> pivot = std::move(*first);
+      auto lo                      = first;
+      auto hi                      = last;
+
+      while(comp(*++lo, pivot))
+         ;
+      if(lo - 1 == first)
+         while(lo < hi and !comp(*--hi, pivot))
+            ;
+      else
+         while(!comp(*--hi, pivot))
+            ;
+
+      const bool already_partitioned = lo >= hi;
+      if(!already_partitioned) {
+         learn_std::iter_swap(lo, hi);
+         ++lo;
+
+         alignas(64) unsigned char offsets_l[block];
+         alignas(64) unsigned char offsets_r[block];
+
+         auto l_base         = lo;
+         auto r_base         = hi;
+         std::ptrdiff_t n_l  = 0;
+         std::ptrdiff_t n_r  = 0;
+         std::ptrdiff_t at_l = 0;
+         std::ptrdiff_t at_r = 0;
+
+         while(lo < hi) {
+            // Split the unknown elements between the blocks that need them
+            const auto n_unknown = hi - lo;
+            const auto l_split
+                = n_l == 0 ? (n_r == 0 ? n_unknown / 2 : n_unknown) : 0;
+            const auto r_split = n_r == 0 ? n_unknown - l_split : 0;
+
+            const auto l_count = std::min(l_split, block);
+            for(std::ptrdiff_t i = 0; i < l_count; ++i) {
+               offsets_l[n_l] = static_cast<unsigned char>(i);
+               n_l += !comp(*lo, pivot);
+               ++lo;
+            }
+
+            const auto r_count = std::min(r_split, block);
+            for(std::ptrdiff_t i = 0; i < r_count; ++i) {
+               offsets_r[n_r] = static_cast<unsigned char>(i + 1);
+               n_r += comp(*--hi, pivot);
+            }
+
+            const auto n = std::min(n_l, n_r);
+            detail::swap_offsets(l_base,
+                                 r_base,
+                                 offsets_l + at_l,
+                                 offsets_r + at_r,
+                                 n,
+                                 n_l == n_r);
+            n_l -= n;
+            n_r -= n;
+            at_l += n;
+            at_r += n;
+
+            if(n_l == 0) {
+               at_l   = 0;
+               l_base = lo;
+            }
+            if(n_r == 0) {
+               at_r   = 0;
+               r_base = hi;
+            }
+         }
+
+         // One block may still hold misplaced elements
+         if(n_l != 0) {
+            while(n_l-- != 0)
+               learn_std::iter_swap(l_base + offsets_l[at_l + n_l], --hi);
+            lo = hi;
+         }
+         if(n_r != 0) {
+            while(n_r-- != 0)
+               learn_std::iter_swap(r_base - offsets_r[at_r + n_r], lo++);
+            hi = lo;
+         }
+      }
+
+      auto pivot_pos = lo - 1;
+      *first         = std::move(*pivot_pos);
+      *pivot_pos     = std::move(pivot);
+      return {pivot_pos, already_partitioned};
+   }
+
+   // Swaps a few elements of a side that was highly unbalanced
+   template<class RandomIt>
+   void break_patterns(RandomIt first, RandomIt last)
+   {
+      const auto len = last - first;
+      if(len < k_insertion_sort_threshold) return;
+      const auto q = len / 4;
+      learn_std::iter_swap(first, first + q);
+      learn_std::iter_swap(last - 1, last - q);
+      if(len > k_ninther_threshold) {
+         learn_std::iter_swap(first + 1, first + (q + 1));
+         learn_std::iter_swap(first + 2, first + (q + 2));
+         learn_std::iter_swap(last - 2, last - (q + 1));
+         learn_std::iter_swap(last - 3, last - (q + 2));
+      }
+   }
+
+   template<bool branchless, class RandomIt, class Compare>
+   void pdq_sort_loop(RandomIt first,
+                      RandomIt last,
+                      Compare comp,
+                      int bad_allowed,
+                      bool leftmost)
+   {
+      while(true) {
+         const auto len = last - first;
+         if(len < k_insertion_sort_threshold) {
+            detail::insertion_sort(first, last, comp);
+            return;
+         }
+
+         detail::choose_pivot(first, last, comp);
+
+         // *(first - 1) is the pivot of an enclosing partition, so nothing
+         // in the range is smaller. A pivot equal to it means duplicates:
+         // gather them on the left, they're already in their final place.
+         if(!leftmost and !comp(*(first - 1), *first)) {
+            first = detail::pdq_partition_left(first, last, comp) + 1;
+            continue;
+         }
+
+         auto [pivot_pos, already_partitioned]
+             = branchless
+                   ? detail::pdq_partition_right_branchless(first, last, comp)
+                   : detail::pdq_partition_right(first, last, comp);
+
+         const auto l_len = pivot_pos - first;
+         const auto r_len = last - (pivot_pos + 1);
+         if(l_len < len / 8 or r_len < len / 8) {
+            if(--bad_allowed == 0) {
+               detail::heap_sort(first, last, comp);
+               return;
+            }
+            detail::break_patterns(first, pivot_pos);
+            detail::break_patterns(pivot_pos + 1, last);
+         } else if(already_partitioned
+                   and detail::partial_insertion_sort(first, pivot_pos, comp)
+                   and detail::partial_insertion_sort(
+                       pivot_pos + 1, last, comp)) {
+            return; // a balanced, already-partitioned range was sorted
+         }
+
+         detail::pdq_sort_loop<branchless>(
+             first, pivot_pos, comp, bad_allowed, leftmost);
+         first    = pivot_pos + 1;
+         leftmost = false;
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class Compare>
+void pdq_sort(RandomIt first, RandomIt last, Compare comp)
+{
+   if(last - first < 2) return;
+   if(detail::reverse_if_descending(first, last, comp)) return;
+   detail::pdq_sort_loop<
+       detail::is_branchless_sortable_v<RandomIt, Compare>>(
+       first, last, comp, detail::floor_log2(last - first), true);
+}
+
+template<class RandomIt> void pdq_sort(RandomIt first, RandomIt last)
+{
+   learn_std::pdq_sort(first, last, std::less<>{});
+}
+
+// ----------------------------------------------------------------- sort-unique
+// Sorts [first, last) and drops duplicates, returning the new end as unique
+// does: the same result as sort followed by unique, without a second pass
+// over the data.
+//  * pdq_sort finishes its ranges from left to right, so each small range
+//    is compacted down to the output as soon as it is insertion-sorted,
+//    while it is still in cache
+//  * pdq_sort's test for a run of duplicate pivots compares against the
+//    last element written out, and the run is compacted as soon as it has
+//    been gathered
+// Without eq, duplicates are elements that comp finds equivalent. Not
+// stable: which of a run of duplicates survives is unspecified. Elements
+// past the new end are left valid but unspecified.
+namespace detail
+{
+   // Moves the elements of sorted [first, last) that aren't duplicates of
+   // the element before them to out, and returns the new out. Everything in
+   // [front, out) is already sorted and unique, and comes before *first.
+   template<class RandomIt, class BinaryPredicate>
+   RandomIt unique_append(RandomIt front,
+                          RandomIt out,
+                          RandomIt first,
+                          RandomIt last,
+                          BinaryPredicate& eq)
+   {
+      for(; first != last; ++first) {
+         if(out != front and eq(*(out - 1), *first)) continue;
+         if(out != first) *out = std::move(*first);
+         ++out;
+      }
+      return out;
+   }
+
+   // pdq_sort_loop, writing the sorted unique elements of [first, last) to
+   // out. The range is leftmost iff out == front.
+   template<bool branchless,
+            class RandomIt,
+            class Compare,
+            class BinaryPredicate>
+   void sort_unique_loop(RandomIt front,
+                         RandomIt& out,
+                         RandomIt first,
+                         RandomIt last,
+                         Compare comp,
+                         BinaryPredicate& eq,
+                         int bad_allowed)
+   {
+      while(true) {
+         const auto len = last - first;
+         if(len < k_insertion_sort_threshold) {
+            detail::insertion_sort(first, last, comp);
+            out = detail::unique_append(front, out, first, last, eq);
+            return;
+         }
+
+         detail::choose_pivot(first, last, comp);
+
+         // *(out - 1) is the largest element written so far, and nothing
+         // in the range is smaller. A pivot equal to it means duplicates.
+         if(out != front and !comp(*(out - 1), *first)) {
+            auto mid = detail::pdq_partition_left(first, last, comp) + 1;
+            out      = detail::unique_append(front, out, first, mid, eq);
+            first    = mid;
+            continue;
+         }
+
+         auto [pivot_pos, already_partitioned]
+             = branchless
+                   ? detail::pdq_partition_right_branchless(first, last, comp)
+                   : detail::pdq_partition_right(first, last, comp);
+
+         const auto l_len = pivot_pos - first;
+         const auto r_len = last - (pivot_pos + 1);
+         if(l_len < len / 8 or r_len < len / 8) {
+            if(--bad_allowed == 0) {
+               detail::heap_sort(first, last, comp);
+               out = detail::unique_append(front, out, first, last, eq);
+               return;
+            }
+            detail::break_patterns(first, pivot_pos);
+            detail::break_patterns(pivot_pos + 1, last);
+         } else if(already_partitioned
+                   and detail::partial_insertion_sort(first, pivot_pos, comp)
+                   and detail::partial_insertion_sort(
+                       pivot_pos + 1, last, comp)) {
+            out = detail::unique_append(front, out, first, last, eq);
+            return;
+         }
+
+         detail::sort_unique_loop<branchless>(
+             front, out, first, pivot_pos, comp, eq, bad_allowed);
+         first = pivot_pos + 1;
+         out   = detail::unique_append(front, out, pivot_pos, first, eq);
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class Compare, class BinaryPredicate>
+RandomIt
+sort_unique(RandomIt first, RandomIt last, Compare comp, BinaryPredicate eq)
+{
+   if(last - first < 2) return last;
+   if(detail::reverse_if_descending(first, last, comp))
+      return detail::unique_append(first, first, first, last, eq);
+   auto out = first;
+   detail::sort_unique_loop<
+       detail::is_branchless_sortable_v<RandomIt, Compare>>(
+       first, out, first, last, comp, eq, detail::floor_log2(last - first));
+   return out;
+}
+
+template<class RandomIt, class Compare>
+RandomIt sort_unique(RandomIt first, RandomIt last, Compare comp)
+{
+   // Each element is compared with one that isn't greater
+   return learn_std::sort_unique(
+       first, last, comp, [comp](const auto& a, const auto& b) {
+          return !comp(a, b);
+       });
+}
+
+template<class RandomIt> RandomIt sort_unique(RandomIt first, RandomIt last)
+{
+   return learn_std::sort_unique(
+       first, last, std::less<>{}, std::equal_to<>{});
+}
+
+// ------------------------------------------------------------------ radix-sort
+// Stable LSD radix sort on the key returned by key_fn, which must be an
+// integer or an IEEE float/double. Floats are sorted by their total order,
+// so -0.0 comes before +0.0 and NaNs go to the ends.
+//  * one counting pass builds the histograms for every digit
+//  * 8-bit digits, scattered back and forth between the range and one
+//    scratch buffer
+//  * passes where every key has the same digit are skipped
+// O(n) extra memory and sizeof(key) passes over the data, with no
+// comparisons. Being stable, it can stand in for stable_sort on integer keys.
+namespace detail
+{
+   constexpr int k_radix_bits    = 8;
+   constexpr std::size_t k_radix = std::size_t(1) << k_radix_bits;
+
+   // Maps a key to an unsigned integer with the same ordering
+   template<class Key> auto radix_key_bits(Key key)
+   {
+      static_assert(std::is_arithmetic_v<Key> and !std::is_same_v<Key, bool>,
+                    "radix_sort requires an integer or floating point key");
+
+      if constexpr(std::is_floating_point_v<Key>) {
+         static_assert(sizeof(Key) == 4 or sizeof(Key) == 8,
+                       "radix_sort supports float and double keys");
+         using U = std::conditional_t<sizeof(Key) == 4, uint32_t, uint64_t>;
+         constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+         U u;
+         std::memcpy(&u, &key, sizeof(U));
+         return (u & sign) ? U(~u) : U(u | sign);
+      } else {
+         using U = std::make_unsigned_t<Key>;
+         auto u  = U(key);
+         if constexpr(std::is_signed_v<Key>)
+            u ^= U(U(1) << (sizeof(U) * 8 - 1)); // flip the sign bit
+         return u;
+      }
+   }
+
+   template<class RandomIt, class KeyFn>
+   using radix_key_t = decltype(detail::radix_key_bits(
+       std::declval<KeyFn&>()(*std::declval<RandomIt&>())));
+
+   template<class InputIt, class OutputIt, class KeyFn>
+   void radix_scatter(InputIt first,
+                      InputIt last,
+                      OutputIt d_first,
+                      const std::size_t* counts,
+                      int shift,
+                      KeyFn& key_fn)
+   {
+      std::size_t offsets[k_radix];
+      std::size_t sum = 0;
+      for(std::size_t i = 0; i < k_radix; ++i) {
+         offsets[i] = sum;
+         sum += counts[i];
+      }
+
+      for(; first != last; ++first) {
+         auto digit = (detail::radix_key_bits(key_fn(*first)) >> shift)
+                      & (k_radix - 1);
+         d_first[offsets[digit]++] = std::move(*first);
+      }
+   }
+
+   // Fills in the histograms of every digit in one pass over the keys.
+   // Returns n, and the digits that need a pass in passes[0, n): a digit
+   // needs none when every key lands in the same bucket.
+   template<int n_digits, class RandomIt, class KeyFn>
+   int radix_count(RandomIt first,
+                   RandomIt last,
+                   KeyFn& key_fn,
+                   std::size_t* counts,
+                   int* passes)
+   {
+      for(auto ii = first; ii != last; ++ii) {
+         auto u = detail::radix_key_bits(key_fn(*ii));
+         for(int d = 0; d < n_digits; ++d) {
+            auto digit = (u >> (d * k_radix_bits)) & (k_radix - 1);
+            ++counts[d * k_radix + digit];
+         }
+      }
+
+      const auto len = std::size_t(last - first);
+      const auto u0  = detail::radix_key_bits(key_fn(*first));
+      int n_passes   = 0;
+      for(int d = 0; d < n_digits; ++d) {
+         auto digit = (u0 >> (d * k_radix_bits)) & (k_radix - 1);
+         if(counts[d * k_radix + digit] != len) passes[n_passes++] = d;
+      }
+      return n_passes;
+   }
+
+   // Scatters back and forth between [first, last) and a buffer with room
+   // for as many elements, starting from the buffer if in_buffer, until
+   // every pass is done. The elements end up back in [first, last).
+   template<class RandomIt, class BufferIt, class KeyFn>
+   void radix_scatter_passes(RandomIt first,
+                             RandomIt last,
+                             BufferIt buffer,
+                             bool in_buffer,
+                             const std::size_t* counts,
+                             const int* passes,
+                             int n_passes,
+                             KeyFn& key_fn)
+   {
+      const auto buffer_last = buffer + (last - first);
+      for(int i = 0; i < n_passes; ++i) {
+         const auto d     = passes[i];
+         const auto shift = d * k_radix_bits;
+         const auto* c    = &counts[d * k_radix];
+         if(in_buffer)
+            detail::radix_scatter(buffer, buffer_last, first, c, shift, key_fn);
+         else
+            detail::radix_scatter(first, last, buffer, c, shift, key_fn);
+         in_buffer = !in_buffer;
+      }
+      if(in_buffer) learn_std::move(buffer, buffer_last, first);
+   }
+
+   // radix_sort for trivial elements, through a temporary_buffer instead of
+   // a vector. Returns false, having done nothing, when there is no memory
+   // for it.
+   template<class RandomIt, class KeyFn>
+   bool try_radix_sort(RandomIt first, RandomIt last, KeyFn key_fn)
+   {
+      using T = iter_value_t<RandomIt>;
+      using U = radix_key_t<RandomIt, KeyFn>;
+      static_assert(std::is_trivial_v<T>);
+      constexpr int n_digits = int(sizeof(U) * 8 / k_radix_bits);
+
+      const auto len = last - first;
+      if(len < 2) return true;
+      temporary_buffer<T> buffer(len);
+      if(buffer.size() != len) return false;
+
+      std::size_t counts[n_digits * k_radix] = {};
+      int passes[n_digits];
+      const auto n_passes
+          = detail::radix_count<n_digits>(first, last, key_fn, counts, passes);
+      detail::radix_scatter_passes(
+          first, last, buffer.data(), false, counts, passes, n_passes, key_fn);
+      return true;
+   }
+} // namespace detail
+
+template<class RandomIt, class KeyFn>
+void radix_sort(RandomIt first, RandomIt last, KeyFn key_fn)
+{
+   using T = typename std::iterator_traits<RandomIt>::value_type;
+   using U = detail::radix_key_t<RandomIt, KeyFn>;
+   constexpr int n_digits = int(sizeof(U) * 8 / detail::k_radix_bits);
+
+   const auto len = std::size_t(last - first);
+   if(len < 2) return;
+
+   std::vector<std::size_t> counts(n_digits * detail::k_radix, 0);
+   int passes[n_digits];
+   const auto n_passes = detail::radix_count<n_digits>(
+       first, last, key_fn, counts.data(), passes);
+   if(n_passes == 0) return;
+
+   std::vector<T> buffer;
+   bool in_buffer = false;
+   if constexpr(std::is_default_constructible_v<T>) {
+      buffer.resize(len);
+   } else {
+      buffer.assign(std::make_move_iterator(first),
+                    std::make_move_iterator(last));
+      in_buffer = true;
+   }
+
+   detail::radix_scatter_passes(first,
+                                last,
+                                begin(buffer),
+                                in_buffer,
+                                counts.data(),
+                                passes,
+                                n_passes,
+                                key_fn);
+}
+
+template<class RandomIt> void radix_sort(RandomIt first, RandomIt last)
+{
+   learn_std::radix_sort(first, last, [](const auto& x) { return x; });
+}
+
+// ----------------------------------------------------------- radix-sort-unique
+// radix_sort that drops elements whose key equals an earlier one, returning
+// the new end as unique does. Equal keys arrive one after another at their
+// bucket in the last pass, which drops them as it scatters; the buckets are
+// then closed up as they are moved into place. Stable: the first element
+// with each key is the one kept.
+namespace detail
+{
+   // radix_scatter that skips elements whose key is the same as the last
+   // one written to their bucket. Bucket b ends up in [starts[b], ends[b]).
+   template<class InputIt, class OutputIt, class KeyFn>
+   void radix_scatter_unique(InputIt first,
+                             InputIt last,
+                             OutputIt d_first,
+                             const std::size_t* counts,
+                             int shift,
+                             KeyFn& key_fn,
+                             std::size_t* starts,
+                             std::size_t* ends)
+   {
+      using U = decltype(detail::radix_key_bits(key_fn(*first)));
+      U last_keys[k_radix] = {};
+      std::size_t sum      = 0;
+      for(std::size_t i = 0; i < k_radix; ++i) {
+         starts[i] = ends[i] = sum;
+         sum += counts[i];
+      }
+
+      for(; first != last; ++first) {
+         const auto u     = detail::radix_key_bits(key_fn(*first));
+         const auto digit = (u >> shift) & (k_radix - 1);
+         if(ends[digit] != starts[digit] and last_keys[digit] == u) continue;
+         d_first[ends[digit]++] = std::move(*first);
+         last_keys[digit] = u;
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class KeyFn>
+RandomIt radix_sort_unique(RandomIt first, RandomIt last, KeyFn key_fn)
+{
+   using T = typename std::iterator_traits<RandomIt>::value_type;
+   using U = detail::radix_key_t<RandomIt, KeyFn>;
+   constexpr int n_digits = int(sizeof(U) * 8 / detail::k_radix_bits);
+
+   const auto len = std::size_t(last - first);
+   if(len < 2) return last;
+
+   std::vector<std::size_t> counts(n_digits * detail::k_radix, 0);
+   int passes[n_digits];
+   const auto n_passes = detail::radix_count<n_digits>(
+       first, last, key_fn, counts.data(), passes);
+   if(n_passes == 0) return first + 1; // every key is the same
+
+   std::vector<T> buffer;
+   bool in_buffer = false;
+   if constexpr(std::is_default_constructible_v<T>) {
+      buffer.resize(len);
+   } else {
+      buffer.assign(std::make_move_iterator(first),
+                    std::make_move_iterator(last));
+      in_buffer = true;
+   }
+
+   for(int i = 0; i + 1 < n_passes; ++i) {
+      const auto d     = passes[i];
+      const auto shift = d * detail::k_radix_bits;
+      const auto* c    = &counts[d * detail::k_radix];
+      if(in_buffer)
+         detail::radix_scatter(
+             begin(buffer), end(buffer), first, c, shift, key_fn);
+      else
+         detail::radix_scatter(first, last, begin(buffer), c, shift, key_fn);
+      in_buffer = !in_buffer;
+   }
+
+   const auto d     = passes[n_passes - 1];
+   const auto shift = d * detail::k_radix_bits;
+   const auto* c    = &counts[d * detail::k_radix];
+   std::size_t starts[detail::k_radix];
+   std::size_t ends[detail::k_radix];
+   auto close_up = [&](auto from) {
+      auto out = first;
+      for(std::size_t b = 0; b < detail::k_radix; ++b)
+         out = detail::merge_tail<true>(from + starts[b], from + ends[b], out);
+      return out;
+   };
+   if(in_buffer) {
+      detail::radix_scatter_unique(
+          begin(buffer), end(buffer), first, c, shift, key_fn, starts, ends);
+      return close_up(first);
+   }
+   detail::radix_scatter_unique(
+       first, last, begin(buffer), c, shift, key_fn, starts, ends);
+   return close_up(begin(buffer));
+}
+
+template<class RandomIt>
+RandomIt radix_sort_unique(RandomIt first, RandomIt last)
+{
+   return learn_std::radix_sort_unique(
+       first, last, [](const auto& x) { return x; });
+}
+
+// -------------------------------------------------------------- msd-radix-sort
+// In-place MSD radix sort (American flag sort) on the same keys as
+// radix_sort. Each level counts one 8-bit digit, then permutes elements
+// into their buckets with swaps driven by per-bucket cursors, and recurses
+// into the buckets on the next digit. Buckets too small to be worth a
+// histogram go to introsort.
+// O(1) extra memory besides the histograms, at most sizeof(key) levels of
+// recursion. Not stable.
+namespace detail
+{
+   constexpr std::ptrdiff_t k_msd_radix_threshold = 64;
+
+   template<class RandomIt, class KeyFn>
+   void msd_radix_sort(RandomIt first, RandomIt last, KeyFn& key_fn, int shift)
+   {
+      auto digit_of = [&](const auto& x) {
+         return std::size_t(
+             (detail::radix_key_bits(key_fn(x)) >> shift) & (k_radix - 1));
+      };
+
+      while(true) {
+         if(last - first < k_msd_radix_threshold) {
+            detail::introsort(first, last, [&](const auto& a, const auto& b) {
+               return detail::radix_key_bits(key_fn(a))
+                      < detail::radix_key_bits(key_fn(b));
+            });
+            return;
+         }
+
+         std::size_t counts[k_radix] = {};
+         for(auto ii = first; ii != last; ++ii) ++counts[digit_of(*ii)];
+
+         // Every key shares this digit: move on to the next one
+         if(counts[digit_of(*first)] == std::size_t(last - first)) {
+            if(shift == 0) return;
+            shift -= k_radix_bits;
+            continue;
+         }
+
+         std::size_t heads[k_radix];
+         std::size_t tails[k_radix];
+         std::size_t sum = 0;
+         for(std::size_t b = 0; b < k_radix; ++b) {
+            heads[b] = sum;
+            sum += counts[b];
+            tails[b] = sum;
+         }
+
+         // Swap each element straight into the next free slot of its bucket
+         for(std::size_t b = 0; b < k_radix; ++b) {
+            while(heads[b] < tails[b]) {
+               auto d = digit_of(first[heads[b]]);
+               if(d == b)
+                  ++heads[b];
+               else
+                  learn_std::iter_swap(first + heads[b], first + heads[d]++);
+            }
+         }
+
+         if(shift == 0) return;
+         for(std::size_t b = 0, start = 0; b < k_radix; start = tails[b++])
+            if(tails[b] - start > 1)
+               detail::msd_radix_sort(first + start,
+                                      first + tails[b],
+                                      key_fn,
+                                      shift - k_radix_bits);
+         return;
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class KeyFn>
+void msd_radix_sort(RandomIt first, RandomIt last, KeyFn key_fn)
+{
+   using U = detail::radix_key_t<RandomIt, KeyFn>;
+   if(last - first < 2) return;
+   detail::msd_radix_sort(
+       first, last, key_fn, int(sizeof(U) * 8) - detail::k_radix_bits);
+}
+
+template<class RandomIt> void msd_radix_sort(RandomIt first, RandomIt last)
+{
+   learn_std::msd_radix_sort(first, last, [](const auto& x) { return x; });
+}
+
+// ----------------------------------------------------------------- string-sort
+// Multikey quicksort (Bentley and Sedgewick) for ranges of std::string,
+// std::string_view, or nul-terminated char pointers. Each round partitions
+// three ways on the character at one depth; the "equal" part moves on to the
+// next character, so a shared prefix is looked at once rather than at every
+// level of the recursion. Small ranges are insertion-sorted on their
+// suffixes from the current depth.
+namespace detail
+{
+   constexpr std::ptrdiff_t k_string_sort_threshold = 16;
+
+   // Character at depth plus one, or 0 past the end of the string. Callers
+   // only ask for depth d after seeing d characters, so a nul-terminated
+   // string is never read past its terminator.
+   template<class S> int string_char_at(const S& s, std::size_t depth)
+   {
+      if constexpr(std::is_pointer_v<S>) {
+         return s[depth] == '\0'
+                    ? 0
+                    : int(static_cast<unsigned char>(s[depth])) + 1;
+      } else {
+         const auto sv = std::string_view(s);
+         return depth < sv.size()
+                    ? int(static_cast<unsigned char>(sv[depth])) + 1
+                    : 0;
+      }
+   }
+
+   template<class RandomIt>
+   void string_sort(RandomIt first, RandomIt last, std::size_t depth)
+   {
+      auto char_at = [&](const auto& s) {
+         return detail::string_char_at(s, depth);
+      };
+
+      while(last - first > k_string_sort_threshold) {
+         // Median of three characters
+         int a = char_at(*first);
+         int b = char_at(*(first + (last - first) / 2));
+         int c = char_at(*(last - 1));
+         if(a > b) std::swap(a, b);
+         if(b > c) b = std::max(a, c);
+         const int pivot = b;
 
-   if(first1 == last1) return learn_std::copy(first2, last2, d_first);
-   return learn_std::copy(first1, last1, d_first);
+         auto lt = first;
+         auto gt = last;
+         for(auto ii = first; ii < gt;) {
+            const int x = char_at(*ii);
+            if(x < pivot)
+               learn_std::iter_swap(lt++, ii++);
+            else if(x > pivot)
+               learn_std::iter_swap(ii, --gt);
+            else
+               ++ii;
+         }
+
+         detail::string_sort(first, lt, depth);
+         detail::string_sort(gt, last, depth);
+         if(pivot == 0) return; // the equal strings all ended here
+
+         first = lt;
+         last  = gt;
+         ++depth;
+      }
+
+      detail::insertion_sort(first, last, [&](const auto& a, const auto& b) {
+         for(auto d = depth;; ++d) {
+            const int x = detail::string_char_at(a, d);
+            const int y = detail::string_char_at(b, d);
+            if(x != y) return x < y;
+            if(x == 0) return false;
+         }
+      });
+   }
+} // namespace detail
+
+template<class RandomIt> void string_sort(RandomIt first, RandomIt last)
+{
+   detail::string_sort(first, last, 0);
 }
 
-template<class InputIt1, class InputIt2, class OutputIt>
-constexpr OutputIt merge(InputIt1 first1,
-                         InputIt1 last1,
-                         InputIt2 first2,
-                         InputIt2 last2,
-                         OutputIt d_first)
+// ----------------------------------------------------------------- stable-sort
+// Run-adaptive merge sort:
+//  * natural ascending runs are used as they are, strictly descending runs
+//    are reversed, and runs shorter than k_min_run are extended with a
+//    binary insertion sort
+//  * runs are merged in the order chosen by Powersort (Munro and Wild),
+//    which keeps the run stack O(log n) deep and the merge cost within
+//    O(n + n H) for run-length entropy H
+//  * merges go through a scratch buffer of n/2 elements and gallop; if the
+//    buffer can't be had they fall back to SymMerge
+// Presorted input costs close to O(n); the worst case is O(n log n).
+namespace detail
 {
-   return learn_std::merge(
-       first1, last1, first2, last2, d_first, [](auto& a, auto& b) {
-          return a < b;
-       });
+   constexpr std::ptrdiff_t k_min_run = 32;
+
+   // Sorts [first, last) given that [first, sorted_end) is sorted
+   template<class RandomIt, class Compare>
+   void binary_insertion_sort(RandomIt first,
+                              RandomIt sorted_end,
+                              RandomIt last,
+                              Compare comp)
+   {
+      for(auto ii = sorted_end; ii != last; ++ii) {
+         auto pos = learn_std::partition_point(
+             first, ii, [&](const auto& x) { return !comp(*ii, x); });
+         if(pos == ii) continue;
+         iter_value_t<RandomIt> value = std::move(*ii);
+         learn_std::move_backward(pos, ii, ii + 1);
+         *pos = std::move(value);
+      }
+   }
+
+   // Returns the end of the run starting at first, after making it
+   // ascending and at least k_min_run long (or up to last)
+   template<class RandomIt, class Compare>
+   RandomIt next_run(RandomIt first, RandomIt last, Compare comp)
+   {
+      auto run_end = first + 1;
+      if(run_end == last) return last;
+
+      if(comp(*run_end, *first)) {
+         while(++run_end != last and comp(*run_end, *(run_end - 1)))
+            ;
+         learn_std::reverse(first, run_end); // strict, so stays stable
+      } else {
+         while(++run_end != last and !comp(*run_end, *(run_end - 1)))
+            ;
+      }
+
+      const auto min_end = last - first < k_min_run ? last : first + k_min_run;
+      if(run_end < min_end) {
+         detail::binary_insertion_sort(first, run_end, min_end, comp);
+         run_end = min_end;
+      }
+      return run_end;
+   }
+
+   // Powersort node power of the boundary between runs [begin_a, begin_b)
+   // and [begin_b, end_b) out of n: the first binary digit at which the
+   // runs' midpoints, as fractions of n, differ.
+   inline int powersort_node_power(std::ptrdiff_t begin_a,
+                                   std::ptrdiff_t begin_b,
+                                   std::ptrdiff_t end_b,
+                                   std::ptrdiff_t n)
+   {
+      // Midpoints are l / 2n and r / 2n
+      auto l           = std::size_t(begin_a + begin_b);
+      auto r           = std::size_t(begin_b + end_b);
+      const auto two_n = 2 * std::size_t(n);
+      for(int power = 1;; ++power) {
+         l *= 2;
+         r *= 2;
+         const bool bit_l = l >= two_n;
+         const bool bit_r = r >= two_n;
+         if(bit_l != bit_r) return power;
+         if(bit_l) {
+            l -= two_n;
+            r -= two_n;
+         }
+      }
+   }
+
+   template<class RandomIt, class Compare, class T>
+   void powersort(RandomIt first,
+                  RandomIt last,
+                  Compare comp,
+                  temporary_buffer<T>& buffer)
+   {
+      struct run
+      {
+         RandomIt first;
+         RandomIt last;
+         int power; // of the boundary with the next run
+      };
+
+      const auto n              = last - first;
+      std::ptrdiff_t min_gallop = k_min_gallop;
+      run stack[sizeof(std::size_t) * 8 + 1];
+      int top = 0;
+
+      auto cur_first = first;
+      auto cur_last  = detail::next_run(first, last, comp);
+      while(cur_last != last) {
+         auto next_last = detail::next_run(cur_last, last, comp);
+         auto power     = detail::powersort_node_power(
+             cur_first - first, cur_last - first, next_last - first, n);
+         while(top > 0 and stack[top - 1].power > power) {
+            --top;
+            detail::merge_adaptive(stack[top].first,
+                                   stack[top].last,
+                                   cur_last,
+                                   comp,
+                                   buffer,
+                                   min_gallop);
+            cur_first = stack[top].first;
+         }
+         stack[top++] = {cur_first, cur_last, power};
+         cur_first    = cur_last;
+         cur_last     = next_last;
+      }
+
+      while(top > 0) {
+         --top;
+         detail::merge_adaptive(stack[top].first,
+                                stack[top].last,
+                                cur_last,
+                                comp,
+                                buffer,
+                                min_gallop);
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class Compare>
+void stable_sort(RandomIt first, RandomIt last, Compare comp)
+{
+   using T = typename std::iterator_traits<RandomIt>::value_type;
+   if(last - first < 2) return;
+   detail::temporary_buffer<T> buffer((last - first) / 2);
+   detail::powersort(first, last, comp, buffer);
 }
 
-// --------------------------------------------------------------- inplace-merge
+template<class RandomIt> void stable_sort(RandomIt first, RandomIt last)
+{
+   learn_std::stable_sort(first, last, std::less<>{});
+}
 
-template<class BidirIt, class Compare>
-void inplace_merge(BidirIt first, BidirIt middle, BidirIt last, Compare comp)
+// ----------------------------------------------------------- block-stable-sort
+// Stable sort in O(1) extra memory, with O(n log n) comparisons and moves:
+// a block merge sort in the GrailSort family (Astrelin), for when
+// stable_sort can't get a buffer and would fall back to O(n log^2 n).
+//  * the first elements of about 4 sqrt(n) distinct values are gathered,
+//    in order, at the front as keys; the rest keeps its order
+//  * the rest is insertion-sorted in runs of 16, and merged bottom-up
+//  * while runs are no longer than the keys, a merge swaps the left run
+//    into the keys and merges it back, swapping as it goes
+//  * longer runs are cut into blocks of about sqrt(2m). One key tags each
+//    block, so that a selection sort by first element, then tag, can put
+//    them in order stably; a block's worth of keys is the buffer that
+//    merges each block with what is left of the one before.
+//  * the keys, being distinct, are heap-sorted and merged back in
+// Short of distinct values for all that, every distinct value is a key,
+// and the block merges rotate instead of swapping through a buffer. There
+// are few enough values that this stays linear per level.
+namespace detail
 {
-   // base case
-   if(std::distance(first, last) <= 1) return;   // nothing to do
-   if(middle == first) return;                   // we're done
-   if(middle == last) return;                    // also done
-   if(std::is_sorted(first, last, comp)) return; // also done
+   constexpr std::ptrdiff_t k_block_sort_run = 16;
 
-   // ----
-   // Move elements such that every element in [first, middle)
-   // is <= to every [middle, last)
-   //
-   // Compare pairs, moving outwards from middle
-   auto s1     = std::prev(middle);
-   auto s2     = middle;
-   auto start1 = s1;
-   auto start2 = s2;
+   // Smallest power of two whose square is at least n
+   inline std::ptrdiff_t block_sort_block_size(std::ptrdiff_t n)
+   {
+      std::ptrdiff_t bs = 1;
+      while(bs * bs < n) bs *= 2;
+      return bs;
+   }
 
-   while(comp(*s2, *s1)) {
-      start1 = s1--;
-      start2 = s2++;
-      if(start1 == first or s2 == last) break;
+   // Keys that merging two runs of length m takes: a tag per block, and a
+   // buffer as long as a block
+   inline std::ptrdiff_t block_sort_keys(std::ptrdiff_t m)
+   {
+      const auto bs = detail::block_sort_block_size(2 * m);
+      return 2 * m / bs + bs;
    }
 
-   // Shift start2 as far right as possible
-   while(s2 != last and comp(*s2, *start1)) start2 = s2++;
-   s1 = start1; // Shift start1 as far left as possible
-   while(s1 != first and comp(*start2, *s1)) start1 = s1--;
+   // Gathers the first elements of up to `want` distinct values at the
+   // front, sorted, and keeps the order of everything else. Returns how
+   // many it found.
+   template<class RandomIt, class Compare>
+   std::ptrdiff_t collect_keys(RandomIt first,
+                               RandomIt last,
+                               std::ptrdiff_t want,
+                               Compare& comp)
+   {
+      auto keys             = first; // found so far: [keys, keys + n_keys)
+      std::ptrdiff_t n_keys = 1;
+      for(auto ii = first + 1; ii != last and n_keys < want; ++ii) {
+         auto pos = learn_std::partition_point(
+             keys, keys + n_keys, [&](const auto& x) { return comp(x, *ii); });
+         if(pos != keys + n_keys and !comp(*ii, *pos)) continue;
 
-   start2++;
-   middle = learn_std::rotate(start1, middle, start2);
+         // Bring the keys up against *ii, and insert it among them
+         const auto gap = ii - (keys + n_keys);
+         learn_std::rotate(keys, keys + n_keys, ii);
+         keys += gap;
+         pos += gap;
+         learn_std::rotate(pos, ii, ii + 1);
+         ++n_keys;
+      }
+      learn_std::rotate(first, keys, keys + n_keys);
+      return n_keys;
+   }
 
-   // ---- Done
+   // Merges [first, middle) and [middle, last) by swapping [first, middle)
+   // into the buffer at buf, then swapping elements from either side into
+   // place. The left side goes first on ties iff left_first. Stops once a
+   // side runs out, with the rest of the other at the end: returns where
+   // that rest starts, and whether it was the left side that ran out.
+   template<class RandomIt, class Compare>
+   std::pair<RandomIt, bool> swap_merge(RandomIt buf,
+                                        RandomIt first,
+                                        RandomIt middle,
+                                        RandomIt last,
+                                        Compare& comp,
+                                        bool left_first)
+   {
+      const auto b_last = learn_std::swap_ranges(first, middle, buf);
+      auto b            = buf;
+      auto out          = first;
+      auto ii           = middle;
+      while(b != b_last and ii != last) {
+         if(left_first ? comp(*ii, *b) : !comp(*b, *ii))
+            learn_std::iter_swap(out++, ii++);
+         else
+            learn_std::iter_swap(out++, b++);
+      }
+      if(b == b_last) return {ii, true};
+      learn_std::swap_ranges(b, b_last, out);
+      return {out, false};
+   }
 
-   // ---- Now inplace-merge the sub-ranges
-   learn_std::inplace_merge(first, start1, middle, comp);
-   learn_std::inplace_merge(middle, start2, last, comp);
-}
+   // swap_merge for a right side no longer than the buffer, merging from
+   // the back. The left side goes first on ties.
+   template<class RandomIt, class Compare>
+   void swap_merge_back(RandomIt buf,
+                        RandomIt first,
+                        RandomIt middle,
+                        RandomIt last,
+                        Compare& comp)
+   {
+      auto b_last = learn_std::swap_ranges(middle, last, buf);
+      auto ii     = middle;
+      auto out    = last;
+      while(b_last != buf and ii != first) {
+         if(comp(*(b_last - 1), *(ii - 1)))
+            learn_std::iter_swap(--out, --ii);
+         else
+            learn_std::iter_swap(--out, --b_last);
+      }
+      learn_std::swap_ranges(buf, b_last, out - (b_last - buf));
+   }
 
-template<class BidirIt>
-void inplace_merge(BidirIt first, BidirIt middle, BidirIt last)
+   // swap_merge without a buffer: rotates runs of the left side past runs
+   // of the right. Each rotation costs the length of what is left of the
+   // left side, so that had better be the shorter one, or hold few values.
+   template<class RandomIt, class Compare>
+   std::pair<RandomIt, bool> rotate_merge(RandomIt first,
+                                          RandomIt middle,
+                                          RandomIt last,
+                                          Compare& comp,
+                                          bool left_first)
+   {
+      while(first != middle and middle != last) {
+         // What of the right side goes before *first
+         auto ii = left_first
+                       ? detail::gallop_lower(middle, last, *first, comp)
+                       : detail::gallop_upper(middle, last, *first, comp);
+         if(ii != middle) {
+            learn_std::rotate(first, middle, ii);
+            first += ii - middle;
+            middle = ii;
+            if(middle == last) break;
+         }
+         // What of the left side goes before *middle
+         first = left_first
+                     ? detail::gallop_upper(first, middle, *middle, comp)
+                     : detail::gallop_lower(first, middle, *middle, comp);
+      }
+      if(first == middle) return {middle, true};
+      return {first, false};
+   }
+
+   // rotate_merge moving the right side, which had better be the shorter.
+   // The left side goes first on ties.
+   template<class RandomIt, class Compare>
+   void rotate_merge_back(RandomIt first,
+                          RandomIt middle,
+                          RandomIt last,
+                          Compare& comp)
+   {
+      while(first != middle and middle != last) {
+         // What of the left side goes after all of the right
+         const auto& back = *(last - 1);
+         auto ii          = learn_std::partition_point(
+             first, middle, [&](const auto& x) { return !comp(back, x); });
+         learn_std::rotate(ii, middle, last);
+         last   = ii + (last - middle);
+         middle = ii;
+         if(first == middle) break;
+         // What of the right side goes after *(middle - 1) is in place
+         last = learn_std::partition_point(middle, last, [&](const auto& x) {
+            return comp(x, *(middle - 1));
+         });
+      }
+   }
+
+   // Merges sorted [first, middle) and [middle, last) in blocks of bs, with
+   // the tags at keys in order. middle - first is at least bs, and last -
+   // middle no more. The buffer at buf holds a block, if buffered.
+   template<class RandomIt, class Compare>
+   void block_merge(RandomIt keys,
+                    RandomIt buf,
+                    bool buffered,
+                    std::ptrdiff_t bs,
+                    RandomIt first,
+                    RandomIt middle,
+                    RandomIt last,
+                    Compare& comp)
+   {
+      // The left side's blocks end at middle; any odd part is at its front
+      const auto blocks   = first + (middle - first) % bs;
+      const auto n_left   = (middle - blocks) / bs;
+      const auto n_blocks = n_left + (last - middle) / bs;
+      const auto tail     = blocks + n_blocks * bs;
+
+      if(n_blocks > n_left) {
+         // Order the blocks by first element, and by tag between equals.
+         // mid_tag follows the first tag of the right side.
+         auto mid_tag = n_left;
+         for(std::ptrdiff_t i = 0; i + 1 < n_blocks; ++i) {
+            auto min = i;
+            for(auto j = i + 1; j < n_blocks; ++j) {
+               const auto a = blocks + j * bs;
+               const auto b = blocks + min * bs;
+               if(comp(*a, *b) or (!comp(*b, *a) and comp(keys[j], keys[min])))
+                  min = j;
+            }
+            if(min == i) continue;
+            learn_std::swap_ranges(
+                blocks + i * bs, blocks + (i + 1) * bs, blocks + min * bs);
+            learn_std::iter_swap(keys + i, keys + min);
+            if(mid_tag == i)
+               mid_tag = min;
+            else if(mid_tag == min)
+               mid_tag = i;
+         }
+
+         // Merge each block with what is left of the blocks before it. When
+         // the next block comes from the same side, that is in place.
+         auto frag      = first;
+         bool frag_left = true;
+         for(std::ptrdiff_t i = 0; i < n_blocks; ++i) {
+            const auto block = blocks + i * bs;
+            const bool left  = comp(keys[i], keys[mid_tag]);
+            if(frag == block or left == frag_left) {
+               frag      = block;
+               frag_left = left;
+               continue;
+            }
+            auto [rest, frag_done]
+                = buffered ? detail::swap_merge(
+                                 buf, frag, block, block + bs, comp, frag_left)
+                           : detail::rotate_merge(
+                                 frag, block, block + bs, comp, frag_left);
+            frag = rest;
+            if(frag_done) frag_left = left;
+         }
+         detail::heap_sort(keys, keys + n_blocks, comp);
+      }
+
+      // The right side's odd part, against everything before it
+      if(tail != last) {
+         if(buffered)
+            detail::swap_merge_back(buf, first, tail, last, comp);
+         else
+            detail::rotate_merge_back(first, tail, last, comp);
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class Compare>
+void block_stable_sort(RandomIt first, RandomIt last, Compare comp)
 {
-   learn_std::inplace_merge(
-       first, middle, last, [](auto& a, auto& b) { return a < b; });
+   constexpr auto run = detail::k_block_sort_run;
+   const auto n       = last - first;
+   if(n <= run) {
+      detail::insertion_sort(first, last, comp);
+      return;
+   }
+
+   // Enough keys for the longest merge, if there are that many values
+   std::ptrdiff_t top = run;
+   while(2 * top < n) top *= 2;
+   const auto n_keys = detail::collect_keys(
+       first, last, detail::block_sort_keys(top), comp);
+   const auto data = first + n_keys;
+   const auto len  = last - data;
+
+   for(std::ptrdiff_t i = 0; i < len; i += run)
+      detail::insertion_sort(data + i, data + std::min(i + run, len), comp);
+
+   for(std::ptrdiff_t m = run; m < len; m *= 2) {
+      detail::heap_sort(first, data, comp); // the buffer leaves them shuffled
+      const auto bs       = detail::block_sort_block_size(2 * m);
+      const bool buffered = detail::block_sort_keys(m) <= n_keys;
+      const auto block    = buffered ? bs : (2 * m + n_keys - 1) / n_keys;
+      for(std::ptrdiff_t lo = 0; len - lo > m; lo += 2 * m) {
+         const auto middle = data + lo + m;
+         const auto hi     = data + std::min(lo + 2 * m, len);
+         if(!comp(*middle, *(middle - 1))) continue;
+         if(m <= n_keys)
+            detail::swap_merge(first, data + lo, middle, hi, comp, true);
+         else
+            detail::block_merge(first,
+                                first + (buffered ? n_keys - bs : 0),
+                                buffered,
+                                block,
+                                data + lo,
+                                middle,
+                                hi,
+                                comp);
+      }
+   }
+
+   detail::heap_sort(first, data, comp);
+   detail::rotate_merge(first, data, last, comp, true);
 }
 
-// -------------------------------------------------------------- is-sorted-util
-template<class ForwardIt, class Compare>
-constexpr ForwardIt
-is_sorted_until(ForwardIt first, ForwardIt last, Compare comp)
+template<class RandomIt> void block_stable_sort(RandomIt first, RandomIt last)
 {
-   auto ii = learn_std::adjacent_find(
-       first, last, [&](auto& a, auto& b) { return comp(b, a); });
-   return ii == last ? last : std::next(ii);
+   learn_std::block_stable_sort(first, last, std::less<>{});
 }
 
-template<class ForwardIt>
-constexpr ForwardIt is_sorted_until(ForwardIt first, ForwardIt last)
+// ------------------------------------------------------------------ sort-probe
+// sort looks at a sample of the range before choosing how to sort it:
+//  * adjacent pairs, about one every 64 elements, in up to 64 slices of
+//    at least 4 pairs; a slice is sorted when its pairs all go the same way
+//  * about sqrt(n) elements, up to 1024, whose positions are merge sorted
+//    by element to count their inversions and duplicates
+// Positions are spread evenly, jittered so that periodic data can't hide.
+// From the estimates, in order:
+//  * run-merge (stable_sort's powersort) when at most one slice in 16
+//    isn't sorted, and the sample's inversions are further from a half
+//    than a shuffled sample's would plausibly be: the range is a few runs,
+//    or sorted but for a patch
+//  * pdq_sort when fewer than one sampled pair in 16 is out of order, or
+//    half of the sample repeats: it finishes partitions that are already
+//    sorted with a bounded insertion sort, and sets runs of duplicates
+//    aside in one pass
+//  * LSD radix_sort on integers under std::less or std::greater, when the
+//    sample's spread of keys takes no more than log2(n) / 8 byte passes
+//  * the AVX2/AVX-512 quicksort on contiguous 32/64-bit integers, floats
+//    and doubles under plain operator<, when the CPU has it
+//  * pdq_sort otherwise
+// Ranges shorter than 4096 elements skip the probe, and take the SIMD
+// quicksort or introsort. The overloads taking a sort_stats report the
+// estimates and the choice. The thresholds are from 2^24 uint64 and int32
+// keys on one x86-64 core.
+// sort throws nothing of its own. run-merge needs a buffer of n / 2
+// elements, and radix_sort one of n; each is tried for, as stable_sort
+// does, and if there isn't the memory the range goes to pdq_sort instead.
+// Code that must not allocate at all, say to stay in a memory budget,
+// calls pdq_sort.
+enum class sort_engine
 {
-   return learn_std::is_sorted_until(
-       first, last, [](auto& a, auto& b) { return a < b; });
+   introsort,
+   simd_sort,
+   pdq_sort,
+   run_merge,
+   radix_sort
+};
+
+struct sort_stats
+{
+   sort_engine engine  = sort_engine::introsort;
+   std::size_t size    = 0; // of the range
+   std::size_t sampled = 0; // elements the probe read, 0 if it didn't run
+   double runs         = 0; // estimated number of ascending runs
+   double unsorted     = 0; // fraction of slices that aren't sorted
+   double inversions   = 0; // fraction of sampled pairs out of order
+   double duplicates   = 0; // fraction of the sample equal to a neighbor
+};
+
+namespace detail
+{
+   constexpr std::ptrdiff_t k_sort_probe_threshold = 1 << 12;
+   constexpr std::ptrdiff_t k_sort_probe_stride    = 64;
+   constexpr std::ptrdiff_t k_sort_probe_slices    = 64;
+   constexpr std::ptrdiff_t k_sort_probe_slice_min = 4; // pairs
+   constexpr std::ptrdiff_t k_sort_probe_sample    = 1 << 10;
+
+   template<class RandomIt,
+            class Compare,
+            class T = typename std::iterator_traits<RandomIt>::value_type>
+   constexpr bool is_radix_sort_candidate_v = std::conjunction_v<
+       std::is_integral<T>,
+       std::negation<std::is_same<T, bool>>,
+       std::disjunction<is_less_compare<Compare, T>,
+                        is_greater_compare<Compare, T>>>;
+
+   // The i-th of n evenly spaced positions, step apart, nudged within the
+   // step so that a period dividing it can't line up with the sample
+   inline std::ptrdiff_t probe_position(std::ptrdiff_t i, std::ptrdiff_t step)
+   {
+      return i * step + (i * 29) % step;
+   }
+
+   // Merge sorts the positions [first, last) by the elements they point at.
+   // Returns the number of inversions among them.
+   template<class RandomIt, class Compare>
+   std::size_t sort_sample(RandomIt data,
+                           std::ptrdiff_t* first,
+                           std::ptrdiff_t* last,
+                           std::ptrdiff_t* buffer,
+                           Compare& comp)
+   {
+      const auto len = last - first;
+      if(len < 2) return 0;
+      const auto mid = first + len / 2;
+      auto inversions
+          = detail::sort_sample(data, first, mid, buffer, comp)
+            + detail::sort_sample(data, mid, last, buffer, comp);
+
+      auto out = buffer;
+      auto ii  = first;
+      auto jj  = mid;
+      while(ii != mid and jj != last) {
+         if(comp(data[*jj], data[*ii])) {
+            inversions += std::size_t(mid - ii);
+            *out++ = *jj++;
+         } else {
+            *out++ = *ii++;
+         }
+      }
+      out = std::copy(ii, mid, out);
+      std::copy(buffer, out, first);
+      return inversions;
+   }
+
+   // Byte passes an LSD radix sort needs for keys between lo and hi
+   template<class T> int radix_passes(T lo, T hi)
+   {
+      auto spread = detail::radix_key_bits(lo) ^ detail::radix_key_bits(hi);
+      int passes  = 0;
+      for(; spread != 0; spread >>= k_radix_bits) ++passes;
+      return passes;
+   }
+} // namespace detail
+
+template<class RandomIt, class Compare>
+sort_stats sort_probe(RandomIt first, RandomIt last, Compare comp)
+{
+   sort_stats stats;
+   const auto n = last - first;
+   stats.size   = std::size_t(n);
+   if(n < 2) return stats;
+
+   { // Runs, from adjacent pairs
+      const auto n_pairs
+          = std::max<std::ptrdiff_t>((n - 1) / detail::k_sort_probe_stride, 1);
+      const auto step     = (n - 1) / n_pairs;
+      const auto n_slices = std::clamp<std::ptrdiff_t>(
+          n_pairs / detail::k_sort_probe_slice_min,
+          1,
+          detail::k_sort_probe_slices);
+      std::ptrdiff_t descents = 0;
+      std::ptrdiff_t unsorted = 0;
+      for(std::ptrdiff_t s = 0; s < n_slices; ++s) {
+         const auto lo         = s * n_pairs / n_slices;
+         const auto hi         = (s + 1) * n_pairs / n_slices;
+         std::ptrdiff_t n_down = 0;
+         for(auto i = lo; i < hi; ++i) {
+            const auto p = detail::probe_position(i, step);
+            n_down += comp(first[p + 1], first[p]);
+         }
+         descents += n_down;
+         unsorted += n_down != 0 and n_down != hi - lo;
+      }
+      stats.sampled  = std::size_t(2 * n_pairs);
+      stats.runs     = 1.0 + double(descents) * double(n - 1) / double(n_pairs);
+      stats.unsorted = double(unsorted) / double(n_slices);
+   }
+
+   // Inversions and duplicates, from a sorted sample
+   const auto m = std::min(std::ptrdiff_t(std::sqrt(double(n))),
+                           detail::k_sort_probe_sample);
+   const auto step = n / m;
+   std::ptrdiff_t sample[detail::k_sort_probe_sample];
+   std::ptrdiff_t buffer[detail::k_sort_probe_sample];
+   for(std::ptrdiff_t i = 0; i < m; ++i)
+      sample[i] = detail::probe_position(i, step);
+   const auto inversions
+       = detail::sort_sample(first, sample, sample + m, buffer, comp);
+   std::ptrdiff_t duplicates = 0;
+   for(std::ptrdiff_t i = 1; i < m; ++i)
+      duplicates += !comp(first[sample[i - 1]], first[sample[i]]);
+   stats.sampled += std::size_t(m);
+   if(m > 1) stats.inversions = 2.0 * double(inversions) / double(m * (m - 1));
+   stats.duplicates = double(duplicates) / double(m);
+
+   // Two standard deviations of the inversions of a shuffled sample
+   const auto shuffled
+       = m > 1 ? 2.0 * std::sqrt((2.0 * double(m) + 5.0)
+                                 / (18.0 * double(m) * double(m - 1)))
+               : 0.5;
+
+   if(stats.unsorted <= 1.0 / 16
+      and std::abs(stats.inversions - 0.5) > shuffled) {
+      stats.engine = sort_engine::run_merge;
+   } else if(stats.inversions < 1.0 / 16 or stats.duplicates >= 0.5) {
+      stats.engine = sort_engine::pdq_sort;
+   } else {
+      stats.engine = detail::is_simd_sort_candidate_v<RandomIt, Compare>
+                         ? sort_engine::simd_sort
+                         : sort_engine::pdq_sort;
+      if constexpr(detail::is_radix_sort_candidate_v<RandomIt, Compare>) {
+         const auto passes
+             = detail::radix_passes(first[sample[0]], first[sample[m - 1]]);
+         if(passes * detail::k_radix_bits <= detail::floor_log2(n))
+            stats.engine = sort_engine::radix_sort;
+      }
+   }
+   return stats;
 }
 
-// ------------------------------------------------------------------- is-sorted
-template<class ForwardIt, class Compare>
-constexpr bool is_sorted(ForwardIt first, ForwardIt last, Compare comp)
+template<class RandomIt> sort_stats sort_probe(RandomIt first, RandomIt last)
 {
-   return learn_std::is_sorted_until(first, last, comp) == last;
+   return learn_std::sort_probe(first, last, std::less<>{});
 }
 
-template<class ForwardIt>
-constexpr bool is_sorted(ForwardIt first, ForwardIt last)
+template<class RandomIt, class Compare>
+constexpr void
+sort(RandomIt first, RandomIt last, Compare comp, sort_stats& stats)
 {
-   return learn_std::is_sorted(
-       first, last, [](auto& a, auto& b) { return a < b; });
+   using T = typename std::iterator_traits<RandomIt>::value_type;
+
+   auto try_simd = [&] {
+      if constexpr(detail::is_simd_sort_candidate_v<RandomIt, Compare>) {
+         auto data = std::addressof(*first);
+         return detail::simd_sort(data, data + (last - first));
+      } else {
+         return false;
+      }
+   };
+
+   if(last - first < detail::k_sort_probe_threshold) {
+      stats        = sort_stats{};
+      stats.size   = std::size_t(last - first);
+      stats.engine = sort_engine::introsort;
+      if(first != last and try_simd())
+         stats.engine = sort_engine::simd_sort;
+      else
+         detail::introsort(first, last, comp);
+      return;
+   }
+
+   stats = learn_std::sort_probe(first, last, comp);
+   switch(stats.engine) {
+   case sort_engine::run_merge: {
+      const auto half = (last - first) / 2;
+      detail::temporary_buffer<T> buffer(half);
+      if(buffer.size() == half) {
+         detail::powersort(first, last, comp, buffer);
+         return;
+      }
+      break;
+   }
+   case sort_engine::radix_sort:
+      if constexpr(detail::is_radix_sort_candidate_v<RandomIt, Compare>) {
+         if constexpr(detail::is_less_compare<Compare, T>::value) {
+            if(detail::try_radix_sort(
+                   first, last, [](const auto& x) { return x; }))
+               return;
+         } else {
+            if(detail::try_radix_sort(first, last, [](const auto& x) {
+                  return decltype(detail::radix_key_bits(x))(
+                      ~detail::radix_key_bits(x));
+               }))
+               return;
+         }
+      }
+      break;
+   case sort_engine::simd_sort:
+      if(try_simd()) return;
+      break;
+   case sort_engine::pdq_sort:
+      break;
+   case sort_engine::introsort:
+      detail::introsort(first, last, comp);
+      return;
+   }
+
+   // The CPU can't, or there's no memory for a buffer
+   stats.engine = sort_engine::pdq_sort;
+   learn_std::pdq_sort(first, last, comp);
 }
 
-// ------------------------------------------------------------------------ sort
+template<class RandomIt>
+constexpr void sort(RandomIt first, RandomIt last, sort_stats& stats)
+{
+   learn_std::sort(first, last, std::less<>{}, stats);
+}
 
 template<class RandomIt, class Compare>
 constexpr void sort(RandomIt first, RandomIt last, Compare comp)
 {
-   auto len = std::distance(first, last);
-   if(len < 2) return; // Base case
-   const auto pivot = std::prev(last);
-   auto mid         = learn_std::partition(
-       first, pivot, [&](auto& a) { return comp(a, *pivot); });
-   learn_std::iter_swap(mid, pivot);
-   learn_std::sort(first, mid, comp);
-   learn_std::sort(++mid, last, comp);
+   sort_stats stats;
+   learn_std::sort(first, last, comp, stats);
 }
 
 template<class RandomIt> constexpr void sort(RandomIt first, RandomIt last)
 {
-   return learn_std::sort(first, last, [](auto& a, auto& b) { return a < b; });
+   learn_std::sort(first, last, std::less<>{});
 }
 
-// ----------------------------------------------------------------- stable-sort
-template<class RandomIt, class Compare>
-void stable_sort(RandomIt first, RandomIt last, Compare comp)
+// ---------------------------------------------------------------- sort-indices
+// Argsort: returns the permutation that sorts [first, last), as indices into
+// the range, and leaves the range alone. For big elements, applying the
+// permutation once is cheaper than moving them through every swap.
+//  * arithmetic keys under std::less or std::greater skip the comparator:
+//    keys of up to 32 bits are packed with their index into one 64-bit word
+//    and those words sorted (SIMD on x86-64); wider keys radix sort
+//    (key, index) pairs
+//  * anything else sorts indices with comp applied through them
+// Ties in the arithmetic paths fall back to index order, so they are stable
+// whichever function is called. Index must be able to hold last - first - 1.
+namespace detail
 {
-   auto len = std::distance(first, last);
-   if(len < 2) return;
-   auto mid = std::next(first, len / 2);
-   learn_std::stable_sort(first, mid, comp);
-   learn_std::stable_sort(mid, last, comp);
-   learn_std::inplace_merge(first, mid, last, comp);
+   template<class T>
+   struct is_radix_key
+       : std::bool_constant<(std::is_integral_v<T>
+                             and not std::is_same_v<T, bool>)
+                            or (std::is_floating_point_v<T>
+                                and (sizeof(T) == 4 or sizeof(T) == 8))>
+   {};
+
+   template<class RandomIt,
+            class Compare,
+            class T = typename std::iterator_traits<RandomIt>::value_type>
+   constexpr bool is_key_argsort_candidate_v = std::conjunction_v<
+       is_radix_key<T>,
+       std::disjunction<is_less_compare<Compare, T>,
+                        is_greater_compare<Compare, T>>>;
+
+   template<class Index> void check_index_range(std::ptrdiff_t len)
+   {
+      static_assert(std::is_integral_v<Index> and std::is_unsigned_v<Index>,
+                    "sort_indices requires an unsigned integer index type");
+      if(len > 0
+         and std::uintmax_t(len - 1) > std::numeric_limits<Index>::max())
+         throw std::length_error("sort_indices: range too long for Index");
+   }
+
+   template<class Index, class Compare, class RandomIt>
+   std::vector<Index> key_sort_indices(RandomIt first, RandomIt last)
+   {
+      using T = typename std::iterator_traits<RandomIt>::value_type;
+      constexpr bool ascending = is_less_compare<Compare, T>::value;
+      const auto len           = std::size_t(last - first);
+      std::vector<Index> indices(len);
+
+      // Unsigned bits that sort ascending in the order Compare asks for.
+      // -0.0 == +0.0, so they share bits and tie on index like other keys
+      auto bits = [](const T& x) {
+         const auto u = detail::radix_key_bits(x == T(0) ? T(0) : x);
+         return ascending ? u : decltype(u)(~u);
+      };
+
+      if constexpr(sizeof(T) <= 4) {
+         if(len <= std::size_t(std::numeric_limits<std::uint32_t>::max())) {
+            std::vector<std::uint64_t> packed(len);
+            for(std::size_t i = 0; i < len; ++i)
+               packed[i] = std::uint64_t(bits(first[i])) << 32 | i;
+            learn_std::sort(begin(packed), end(packed));
+            for(std::size_t i = 0; i < len; ++i)
+               indices[i] = Index(packed[i] & 0xffffffffu);
+            return indices;
+         }
+      }
+
+      struct keyed
+      {
+         decltype(bits(std::declval<const T&>())) key;
+         Index index;
+      };
+      std::vector<keyed> pairs(len);
+      for(std::size_t i = 0; i < len; ++i)
+         pairs[i] = keyed{bits(first[i]), Index(i)};
+      learn_std::radix_sort(
+          begin(pairs), end(pairs), [](const keyed& k) { return k.key; });
+      for(std::size_t i = 0; i < len; ++i) indices[i] = pairs[i].index;
+      return indices;
+   }
+
+   template<class Index, bool Stable, class RandomIt, class Compare>
+   std::vector<Index> sort_indices(RandomIt first, RandomIt last, Compare comp)
+   {
+      detail::check_index_range<Index>(last - first);
+      if constexpr(is_key_argsort_candidate_v<RandomIt, Compare>) {
+         return detail::key_sort_indices<Index, Compare>(first, last);
+      } else {
+         std::vector<Index> indices(std::size_t(last - first));
+         for(std::size_t i = 0; i < indices.size(); ++i) indices[i] = Index(i);
+         auto by_key = [&](Index a, Index b) {
+            return comp(first[a], first[b]);
+         };
+         if constexpr(Stable)
+            learn_std::stable_sort(begin(indices), end(indices), by_key);
+         else
+            learn_std::pdq_sort(begin(indices), end(indices), by_key);
+         return indices;
+      }
+   }
+} // namespace detail
+
+template<class Index = std::size_t, class RandomIt, class Compare>
+std::vector<Index> sort_indices(RandomIt first, RandomIt last, Compare comp)
+{
+   return detail::sort_indices<Index, false>(first, last, comp);
 }
 
-template<class RandomIt> void stable_sort(RandomIt first, RandomIt last)
+template<class Index = std::size_t, class RandomIt>
+std::vector<Index> sort_indices(RandomIt first, RandomIt last)
+{
+   return learn_std::sort_indices<Index>(first, last, std::less<>{});
+}
+
+template<class Index = std::size_t, class RandomIt, class Compare>
+std::vector<Index>
+stable_sort_indices(RandomIt first, RandomIt last, Compare comp)
+{
+   return detail::sort_indices<Index, true>(first, last, comp);
+}
+
+template<class Index = std::size_t, class RandomIt>
+std::vector<Index> stable_sort_indices(RandomIt first, RandomIt last)
+{
+   return learn_std::stable_sort_indices<Index>(first, last, std::less<>{});
+}
+
+// ----------------------------------------------------------------- sort-by-key
+// Sorts [keys_first, keys_last) and applies the same permutation to the
+// values starting at values_first, in place, for data kept as separate
+// arrays. comp compares keys only. To carry several value arrays, pass
+// make_zip_iterator(values1, values2, ...) as values_first. Both ranges are
+// sorted together through a zip_iterator by the ordinary sort and
+// stable_sort, so no array of pairs is built.
+namespace detail
+{
+   template<class Compare> auto by_zip_key(Compare& comp)
+   {
+      // a and b are zip_references, or their value_type when held aside
+      return [&comp](const auto& a, const auto& b) {
+         using std::get;
+         return comp(get<0>(a), get<0>(b));
+      };
+   }
+} // namespace detail
+
+template<class RandomIt1, class RandomIt2, class Compare>
+void sort_by_key(RandomIt1 keys_first,
+                 RandomIt1 keys_last,
+                 RandomIt2 values_first,
+                 Compare comp)
+{
+   const auto values_last = std::next(values_first, keys_last - keys_first);
+   learn_std::sort(learn_std::make_zip_iterator(keys_first, values_first),
+                   learn_std::make_zip_iterator(keys_last, values_last),
+                   detail::by_zip_key(comp));
+}
+
+template<class RandomIt1, class RandomIt2>
+void sort_by_key(RandomIt1 keys_first,
+                 RandomIt1 keys_last,
+                 RandomIt2 values_first)
+{
+   learn_std::sort_by_key(keys_first, keys_last, values_first, std::less<>{});
+}
+
+template<class RandomIt1, class RandomIt2, class Compare>
+void stable_sort_by_key(RandomIt1 keys_first,
+                        RandomIt1 keys_last,
+                        RandomIt2 values_first,
+                        Compare comp)
+{
+   const auto values_last = std::next(values_first, keys_last - keys_first);
+   learn_std::stable_sort(
+       learn_std::make_zip_iterator(keys_first, values_first),
+       learn_std::make_zip_iterator(keys_last, values_last),
+       detail::by_zip_key(comp));
+}
+
+template<class RandomIt1, class RandomIt2>
+void stable_sort_by_key(RandomIt1 keys_first,
+                        RandomIt1 keys_last,
+                        RandomIt2 values_first)
+{
+   learn_std::stable_sort_by_key(
+       keys_first, keys_last, values_first, std::less<>{});
+}
+
+// -------------------------------------------------------------- segmented-sort
+// Sorts each segment of [first, last) on its own. The range is cut at the
+// offsets in [offsets_first, offsets_last), which are non-decreasing
+// positions relative to first: the segments are [first, first + o[0]),
+// [first + o[0], first + o[1]), ..., [first + o[k - 1], last). CSR row
+// offsets work as they are, with or without the leading 0 and trailing n.
+// The segments are bucketed by size first, and then each bucket is sorted
+// in a loop of its own, so there is no per-segment dispatch to mispredict:
+//  * 2 to 8 elements go through the optimal sorting network for that size;
+//    arithmetic keys under std::less/std::greater compare-exchange without
+//    branches
+//  * up to k_segment_insertion_max elements, insertion sort
+//  * longer segments, sort
+// The buckets hold one position per segment, so this allocates O(k).
+namespace detail
+{
+   constexpr std::ptrdiff_t k_segment_network_max   = 8;
+   constexpr std::ptrdiff_t k_segment_insertion_max = 32;
+
+   template<class RandomIt, class Compare>
+   void compare_exchange(RandomIt a, RandomIt b, Compare comp)
+   {
+      if constexpr(is_branchless_sortable_v<RandomIt, Compare>) {
+         const auto x    = *a;
+         const auto y    = *b;
+         const bool swap = comp(y, x);
+         *a              = swap ? y : x;
+         *b              = swap ? x : y;
+      } else {
+         if(comp(*b, *a)) learn_std::iter_swap(a, b);
+      }
+   }
+
+   // Optimal-size sorting networks (Knuth, TAOCP 5.3.4), as the pairs of
+   // positions to compare-exchange in order
+   template<std::ptrdiff_t N> struct sorting_network;
+   template<> struct sorting_network<2>
+   {
+      static constexpr unsigned char pairs[][2] = {{0, 1}};
+   };
+   template<> struct sorting_network<3>
+   {
+      static constexpr unsigned char pairs[][2] = {{0, 1}, {1, 2}, {0, 1}};
+   };
+   template<> struct sorting_network<4>
+   {
+      static constexpr unsigned char pairs[][2]
+          = {{0, 1}, {2, 3}, {0, 2}, {1, 3}, {1, 2}};
+   };
+   template<> struct sorting_network<5>
+   {
+      static constexpr unsigned char pairs[][2] = {{0, 1},
+                                                   {3, 4},
+                                                   {2, 4},
+                                                   {2, 3},
+                                                   {0, 3},
+                                                   {0, 2},
+                                                   {1, 4},
+                                                   {1, 3},
+                                                   {1, 2}};
+   };
+   template<> struct sorting_network<6>
+   {
+      static constexpr unsigned char pairs[][2] = {{1, 2},
+                                                   {4, 5},
+                                                   {0, 2},
+                                                   {3, 5},
+                                                   {0, 1},
+                                                   {3, 4},
+                                                   {2, 5},
+                                                   {0, 3},
+                                                   {1, 4},
+                                                   {2, 4},
+                                                   {1, 3},
+                                                   {2, 3}};
+   };
+   template<> struct sorting_network<7>
+   {
+      static constexpr unsigned char pairs[][2] = {{1, 2},
+                                                   {3, 4},
+                                                   {5, 6},
+                                                   {0, 2},
+                                                   {3, 5},
+                                                   {4, 6},
+                                                   {0, 1},
+                                                   {4, 5},
+                                                   {2, 6},
+                                                   {0, 4},
+                                                   {1, 5},
+                                                   {0, 3},
+                                                   {2, 5},
+                                                   {1, 3},
+                                                   {2, 4},
+                                                   {2, 3}};
+   };
+   template<> struct sorting_network<8>
+   {
+      static constexpr unsigned char pairs[][2] = {{0, 2},
+                                                   {1, 3},
+                                                   {4, 6},
+                                                   {5, 7},
+                                                   {0, 4},
+                                                   {1, 5},
+                                                   {2, 6},
+                                                   {3, 7},
+                                                   {0, 1},
+                                                   {2, 3},
+                                                   {4, 5},
+                                                   {6, 7},
+                                                   {2, 4},
+                                                   {3, 5},
+                                                   {1, 4},
+                                                   {3, 6},
+                                                   {1, 2},
+                                                   {3, 4},
+                                                   {5, 6}};
+   };
+
+   // Sorts [first, first + N)
+   template<std::ptrdiff_t N, class RandomIt, class Compare>
+   void network_sort(RandomIt first, Compare comp)
+   {
+      for(const auto& p : sorting_network<N>::pairs)
+         detail::compare_exchange(first + p[0], first + p[1], comp);
+   }
+
+   struct segment_buckets
+   {
+      using bounds = std::pair<std::ptrdiff_t, std::ptrdiff_t>;
+
+      // Starts of the segments of each length up to k_segment_network_max
+      std::vector<std::ptrdiff_t> tiny[k_segment_network_max + 1];
+      std::vector<bounds> small; // up to k_segment_insertion_max
+      std::vector<bounds> large;
+   };
+
+   template<class ForwardIt>
+   segment_buckets bucket_segments(std::ptrdiff_t len,
+                                   ForwardIt offsets_first,
+                                   ForwardIt offsets_last)
+   {
+      segment_buckets buckets;
+      auto add = [&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+         const auto n = hi - lo;
+         if(n <= k_segment_network_max) {
+            if(n > 1) buckets.tiny[n].push_back(lo);
+         } else if(n <= k_segment_insertion_max) {
+            buckets.small.emplace_back(lo, hi);
+         } else {
+            buckets.large.emplace_back(lo, hi);
+         }
+      };
+
+      std::ptrdiff_t lo = 0;
+      for(; offsets_first != offsets_last; ++offsets_first) {
+         const auto hi = std::ptrdiff_t(*offsets_first);
+         add(lo, hi);
+         lo = hi;
+      }
+      add(lo, len);
+      return buckets;
+   }
+
+   // Sorts the part-th of `parts` equal shares of every tiny and small
+   // bucket. Large segments are left to the caller.
+   template<std::ptrdiff_t N = 2, class RandomIt, class Compare>
+   void sort_short_segments(RandomIt first,
+                            const segment_buckets& buckets,
+                            Compare comp,
+                            unsigned part,
+                            unsigned parts)
+   {
+      auto share = [&](const auto& bucket) {
+         return std::make_pair(bucket.size() * part / parts,
+                               bucket.size() * (part + 1) / parts);
+      };
+
+      const auto& starts = buckets.tiny[N];
+      for(auto [i, end] = share(starts); i != end; ++i)
+         detail::network_sort<N>(first + starts[i], comp);
+
+      if constexpr(N < k_segment_network_max) {
+         detail::sort_short_segments<N + 1>(
+             first, buckets, comp, part, parts);
+      } else {
+         const auto& small = buckets.small;
+         for(auto [i, end] = share(small); i != end; ++i)
+            detail::insertion_sort(
+                first + small[i].first, first + small[i].second, comp);
+      }
+   }
+} // namespace detail
+
+template<class RandomIt, class ForwardIt, class Compare>
+void segmented_sort(RandomIt first,
+                    RandomIt last,
+                    ForwardIt offsets_first,
+                    ForwardIt offsets_last,
+                    Compare comp)
+{
+   const auto buckets
+       = detail::bucket_segments(last - first, offsets_first, offsets_last);
+   detail::sort_short_segments(first, buckets, comp, 0, 1);
+   for(const auto& [lo, hi] : buckets.large)
+      learn_std::sort(first + lo, first + hi, comp);
+}
+
+template<class RandomIt, class ForwardIt>
+void segmented_sort(RandomIt first,
+                    RandomIt last,
+                    ForwardIt offsets_first,
+                    ForwardIt offsets_last)
 {
-   learn_std::stable_sort(first, last, [](auto& a, auto& b) { return a < b; });
+   learn_std::segmented_sort(
+       first, last, offsets_first, offsets_last, std::less<>{});
 }
 
 // ----------------------------------------------------------------- nth-element
-// Quickselect algorithm
+// Introselect:
+//  * median-of-3 (ninther above 128 elements) pivots, and only the side
+//    holding nth is partitioned again
+//  * above 600 elements, Floyd-Rivest: the pivot is selected from an evenly
+//    spaced sample to sit just past nth's expected rank, so one partition
+//    leaves a short range to finish
+//  * once log2(n) rounds have failed to shrink the range by an eighth,
+//    median-of-medians pivots take over, which are linear in the worst case
+namespace detail
+{
+   constexpr std::ptrdiff_t k_floyd_rivest_threshold = 600;
+
+   template<class RandomIt, class Compare>
+   constexpr void median_of_medians_select(RandomIt first,
+                                           RandomIt nth,
+                                           RandomIt last,
+                                           Compare comp);
+
+   // Moves the median of each group of five to the front of the range, and
+   // returns the median of those medians.
+   template<class RandomIt, class Compare>
+   constexpr RandomIt
+   median_of_medians(RandomIt first, RandomIt last, Compare comp)
+   {
+      const auto len = last - first;
+      auto medians   = first;
+      for(std::ptrdiff_t i = 0; i < len; i += 5) {
+         const auto group     = first + i;
+         const auto group_len = std::min<std::ptrdiff_t>(5, len - i);
+         detail::insertion_sort(group, group + group_len, comp);
+         learn_std::iter_swap(medians++, group + (group_len - 1) / 2);
+      }
+      const auto mid = first + (medians - first - 1) / 2;
+      detail::median_of_medians_select(first, mid, medians, comp);
+      return mid;
+   }
+
+   template<class RandomIt, class Compare>
+   constexpr void median_of_medians_select(RandomIt first,
+                                           RandomIt nth,
+                                           RandomIt last,
+                                           Compare comp)
+   {
+      while(last - first > k_insertion_sort_threshold) {
+         learn_std::iter_swap(first,
+                              detail::median_of_medians(first, last, comp));
+         const auto mid = detail::partition_at_pivot(first, last, comp);
+         if(mid == nth) return;
+         if(nth < mid)
+            last = mid;
+         else
+            first = mid + 1;
+      }
+      detail::insertion_sort(first, last, comp);
+   }
+
+   // Selects, from a sample of about n^(2/3) keys, one just past nth's
+   // expected rank on the side away from the middle, and moves it to *first.
+   // Partitioning on it leaves nth in the smaller side with high probability.
+   template<class RandomIt, class Compare>
+   constexpr void floyd_rivest_pivot(RandomIt first,
+                                     RandomIt nth,
+                                     RandomIt last,
+                                     Compare comp);
+
+   template<class RandomIt, class Compare>
+   constexpr void
+   introselect(RandomIt first, RandomIt nth, RandomIt last, Compare comp)
+   {
+      auto bad_rounds = detail::floor_log2(last - first);
+      while(last - first > k_insertion_sort_threshold) {
+         const auto len = last - first;
+         if(len > k_floyd_rivest_threshold)
+            detail::floyd_rivest_pivot(first, nth, last, comp);
+         else
+            detail::choose_pivot(first, last, comp);
+
+         const auto mid = detail::partition_at_pivot(first, last, comp);
+         if(mid == nth) return;
+         if(nth < mid)
+            last = mid;
+         else
+            first = mid + 1;
+
+         if(last - first > len - len / 8 and --bad_rounds <= 0) {
+            detail::median_of_medians_select(first, nth, last, comp);
+            return;
+         }
+      }
+      detail::insertion_sort(first, last, comp);
+   }
+
+   template<class RandomIt, class Compare>
+   constexpr void floyd_rivest_pivot(RandomIt first,
+                                     RandomIt nth,
+                                     RandomIt last,
+                                     Compare comp)
+   {
+      const auto len = last - first;
+      const auto n   = double(len);
+      const auto i   = double(nth - first + 1);
+      const auto z   = std::log(n);
+      const auto s   = 0.5 * std::exp(2.0 * z / 3.0);
+      const auto sd  = 0.5 * std::sqrt(z * s * (n - s) / n)
+                      * (i < n / 2 ? 1.0 : -1.0);
+      const auto m   = std::ptrdiff_t(s);
+      const auto r   = std::clamp(std::ptrdiff_t(i * s / n + sd),
+                                std::ptrdiff_t(0),
+                                m - 1);
+
+      // Evenly spaced rather than contiguous, so sorted runs don't skew it
+      for(std::ptrdiff_t j = 1; j < m; ++j)
+         learn_std::iter_swap(first + j, first + j * len / m);
+      detail::introselect(first, first + r, first + m, comp);
+      learn_std::iter_swap(first, first + r);
+   }
+} // namespace detail
+
 template<class RandomIt, class Compare>
 constexpr void
 nth_element(RandomIt first, RandomIt nth, RandomIt last, Compare comp)
 {
-   while(first != last) {
-      auto pivot = std::prev(last);
-      auto mid   = learn_std::partition(
-          first, pivot, [&](auto& a) { return comp(a, *pivot); });
-      learn_std::iter_swap(mid, pivot);
-      if(mid == nth) break; // we're done
-      if(mid > nth)
-         last = mid;
-      else
-         first = mid;
-   }
+   if(nth == last) return;
+   detail::introselect(first, nth, last, comp);
 }
 
 template<class RandomIt>
@@ -194,12 +2931,55 @@ constexpr void nth_element(RandomIt first, RandomIt nth, RandomIt last)
 }
 
 // ---------------------------------------------------------------- partial-sort
+// A prefix of at most n/64 uses heap-select: a max-heap of the best k so
+// far, which every later element only has to beat at the root. Input that
+// keeps displacing the root (reverse sorted, say) gives up after about
+// twice the replacements random input needs. Larger prefixes, and inputs
+// that gave up, run introselect and then sort the prefix.
+namespace detail
+{
+   constexpr std::ptrdiff_t k_heap_select_ratio = 64;
+
+   // Returns false, leaving [first, last) permuted, once more than `budget`
+   // elements have displaced the root.
+   template<class RandomIt, class Compare>
+   constexpr bool heap_select(RandomIt first,
+                              RandomIt middle,
+                              RandomIt last,
+                              std::ptrdiff_t budget,
+                              Compare comp)
+   {
+      learn_std::make_heap(first, middle, comp);
+      auto beats_root = [&](const auto& x) { return comp(x, *first); };
+      auto ii         = learn_std::find_if(middle, last, beats_root);
+      while(ii != last) {
+         if(budget-- == 0) return false;
+         learn_std::iter_swap(ii, first);
+         detail::heap_sift_down(first, middle, comp);
+         ii = learn_std::find_if(++ii, last, beats_root);
+      }
+      return true;
+   }
+} // namespace detail
+
 template<class RandomIt, class Compare>
 constexpr void
 partial_sort(RandomIt first, RandomIt middle, RandomIt last, Compare comp)
 {
-   if(middle != last) learn_std::nth_element(first, --middle, last, comp);
-   learn_std::sort(first, middle);
+   const auto k = middle - first;
+   const auto n = last - first;
+   if(k == 0) return;
+
+   if(k <= n / detail::k_heap_select_ratio) {
+      const auto budget = 2 * k * detail::floor_log2(n / k);
+      if(detail::heap_select(first, middle, last, budget, comp)) {
+         learn_std::sort_heap(first, middle, comp);
+         return;
+      }
+   }
+
+   learn_std::nth_element(first, middle - 1, last, comp);
+   learn_std::sort(first, middle - 1, comp);
 }
 
 template<class RandomIt>
@@ -252,4 +3032,92 @@ constexpr RandomIt partial_sort_copy(InputIt first,
        first, last, d_first, d_last, [](auto& a, auto& b) { return a < b; });
 }
 
+// ----------------------------------------------------------------------- top-k
+// Keeps the N keys that come first under Compare (by default the N largest)
+// out of a stream. They sit in a max-heap whose root is the threshold a new
+// key has to beat. Once the heap is full, batches of 32/64-bit arithmetic
+// keys from contiguous memory under std::less or std::greater are scanned
+// with SIMD, so the heap is only touched by keys that displace the root.
+template<class T, std::size_t N, class Compare = std::greater<T>> class top_k
+{
+   static_assert(N > 0);
+
+ public:
+   top_k() { heap_.reserve(N); }
+   explicit top_k(Compare comp)
+       : comp_(std::move(comp))
+   {
+      heap_.reserve(N);
+   }
+
+   static constexpr std::size_t capacity() noexcept { return N; }
+   std::size_t size() const noexcept { return heap_.size(); }
+   bool empty() const noexcept { return heap_.empty(); }
+   bool full() const noexcept { return heap_.size() == N; }
+
+   // The last of the kept keys; only keys that come before it get in once
+   // full(). Requires !empty().
+   const T& threshold() const { return heap_.front(); }
+
+   void push(const T& x) { emplace(x); }
+   void push(T&& x) { emplace(std::move(x)); }
+
+   template<class InputIt> void push(InputIt first, InputIt last)
+   {
+      for(; first != last and not full(); ++first) emplace(*first);
+
+      if constexpr(is_simd_filterable_v<InputIt>) {
+         if(first == last) return;
+         const T* ii  = std::addressof(*first);
+         const T* end = ii + (last - first);
+         while(true) {
+            ii = detail::simd_find_before<Compare>(ii, end, heap_.front());
+            if(ii == end) break;
+            replace_top(*ii++);
+         }
+      } else {
+         for(; first != last; ++first)
+            if(comp_(*first, heap_.front())) replace_top(*first);
+      }
+   }
+
+   // The kept keys, in Compare order
+   std::vector<T> sorted() const
+   {
+      auto keys = heap_;
+      learn_std::sort_heap(begin(keys), end(keys), comp_);
+      return keys;
+   }
+
+   void clear() noexcept { heap_.clear(); }
+
+ private:
+   template<class InputIt>
+   static constexpr bool is_simd_filterable_v = std::conjunction_v<
+       std::is_same<typename std::iterator_traits<InputIt>::value_type, T>,
+       detail::is_simd_sortable<T>,
+       std::disjunction<detail::is_less_compare<Compare, T>,
+                        detail::is_greater_compare<Compare, T>>,
+       detail::is_contiguous_iterator<InputIt>>;
+
+   template<class U> void emplace(U&& x)
+   {
+      if(not full()) {
+         heap_.push_back(std::forward<U>(x));
+         learn_std::push_heap(begin(heap_), end(heap_), comp_);
+      } else if(comp_(x, heap_.front())) {
+         replace_top(std::forward<U>(x));
+      }
+   }
+
+   template<class U> void replace_top(U&& x)
+   {
+      heap_.front() = std::forward<U>(x);
+      detail::heap_sift_down(begin(heap_), end(heap_), comp_);
+   }
+
+   std::vector<T> heap_;
+   Compare comp_;
+};
+
 } // namespace learn_std
@@ -0,0 +1,244 @@
+
+#pragma once
+
+// ------- Zip iterator
+// zip-reference, zip-iterator, make-zip-iterator
+
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace learn_std
+{
+// --------------------------------------------------------------- zip-reference
+// What a zip_iterator dereferences to: a tuple of references into each of
+// the zipped sequences, standing in for one element of all of them.
+//  * assigning, or swapping, goes through to the referenced elements
+//  * it converts to value_type, a std::tuple of the elements' values, and
+//    can be assigned from one; assigning from a value_type rvalue moves
+//  * get<I> (found by ADL, like std::get for tuples) and structured
+//    bindings reach the I-th element
+//  * == and < compare lexicographically, as std::tuple does
+// A reference can't tell std::move(*it) from *it, so converting to
+// value_type, or assigning one reference to another, copies the elements.
+// Sorting with it therefore needs copyable elements, and pays copies where
+// a plain array would move.
+template<class... Its> class zip_reference
+{
+ public:
+   using value_type
+       = std::tuple<typename std::iterator_traits<Its>::value_type...>;
+
+   explicit zip_reference(typename std::iterator_traits<Its>::reference... refs)
+       : refs_(refs...)
+   {}
+
+   zip_reference(const zip_reference&) = default;
+
+   zip_reference& operator=(const zip_reference& o)
+   {
+      refs_ = o.refs_;
+      return *this;
+   }
+
+   zip_reference& operator=(const value_type& o)
+   {
+      refs_ = o;
+      return *this;
+   }
+
+   zip_reference& operator=(value_type&& o)
+   {
+      refs_ = std::move(o);
+      return *this;
+   }
+
+   operator value_type() const { return value_type(refs_); }
+
+   template<std::size_t I> friend decltype(auto) get(const zip_reference& r)
+   {
+      return std::get<I>(r.refs_);
+   }
+
+   friend void swap(zip_reference a, zip_reference b)
+   {
+      a.swap_elements(b, std::index_sequence_for<Its...>{});
+   }
+
+   friend bool operator==(const zip_reference& a, const zip_reference& b)
+   {
+      return a.refs_ == b.refs_;
+   }
+   friend bool operator==(const zip_reference& a, const value_type& b)
+   {
+      return a.refs_ == b;
+   }
+   friend bool operator==(const value_type& a, const zip_reference& b)
+   {
+      return a == b.refs_;
+   }
+
+   friend bool operator<(const zip_reference& a, const zip_reference& b)
+   {
+      return a.refs_ < b.refs_;
+   }
+   friend bool operator<(const zip_reference& a, const value_type& b)
+   {
+      return a.refs_ < b;
+   }
+   friend bool operator<(const value_type& a, const zip_reference& b)
+   {
+      return a < b.refs_;
+   }
+
+ private:
+   template<std::size_t... I>
+   void swap_elements(zip_reference& o, std::index_sequence<I...>)
+   {
+      using std::swap;
+      (swap(std::get<I>(refs_), std::get<I>(o.refs_)), ...);
+   }
+
+   std::tuple<typename std::iterator_traits<Its>::reference...> refs_;
+};
+
+// ---------------------------------------------------------------- zip-iterator
+// Walks several sequences in lockstep, so that structure-of-arrays data can
+// be sorted, partitioned and so on as if it were one array of tuples. It is
+// the weakest of the zipped iterators' categories, and a proxy iterator:
+// *it is a zip_reference, not a value_type&. Two zip iterators compare by
+// their first iterators.
+template<class... Its> class zip_iterator
+{
+   static_assert(sizeof...(Its) > 0);
+
+ public:
+   using iterator_category = std::common_type_t<
+       typename std::iterator_traits<Its>::iterator_category...>;
+   using value_type      = typename zip_reference<Its...>::value_type;
+   using difference_type = std::ptrdiff_t;
+   using reference       = zip_reference<Its...>;
+   using pointer         = void;
+
+   zip_iterator() = default;
+   explicit zip_iterator(Its... its)
+       : its_(its...)
+   {}
+
+   // The zipped iterators
+   const std::tuple<Its...>& iterators() const noexcept { return its_; }
+
+   reference operator*() const
+   {
+      return std::apply([](auto&... its) { return reference(*its...); }, its_);
+   }
+
+   reference operator[](difference_type n) const { return *(*this + n); }
+
+   zip_iterator& operator++()
+   {
+      std::apply([](auto&... its) { (++its, ...); }, its_);
+      return *this;
+   }
+
+   zip_iterator& operator--()
+   {
+      std::apply([](auto&... its) { (--its, ...); }, its_);
+      return *this;
+   }
+
+   zip_iterator operator++(int)
+   {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+   }
+
+   zip_iterator operator--(int)
+   {
+      auto tmp = *this;
+      --*this;
+      return tmp;
+   }
+
+   zip_iterator& operator+=(difference_type n)
+   {
+      std::apply([n](auto&... its) { ((its += n), ...); }, its_);
+      return *this;
+   }
+
+   zip_iterator& operator-=(difference_type n) { return *this += -n; }
+
+   friend zip_iterator operator+(zip_iterator it, difference_type n)
+   {
+      return it += n;
+   }
+   friend zip_iterator operator+(difference_type n, zip_iterator it)
+   {
+      return it += n;
+   }
+   friend zip_iterator operator-(zip_iterator it, difference_type n)
+   {
+      return it -= n;
+   }
+
+   friend difference_type operator-(const zip_iterator& a,
+                                    const zip_iterator& b)
+   {
+      return std::get<0>(a.its_) - std::get<0>(b.its_);
+   }
+
+   friend bool operator==(const zip_iterator& a, const zip_iterator& b)
+   {
+      return std::get<0>(a.its_) == std::get<0>(b.its_);
+   }
+   friend bool operator!=(const zip_iterator& a, const zip_iterator& b)
+   {
+      return !(a == b);
+   }
+   friend bool operator<(const zip_iterator& a, const zip_iterator& b)
+   {
+      return std::get<0>(a.its_) < std::get<0>(b.its_);
+   }
+   friend bool operator>(const zip_iterator& a, const zip_iterator& b)
+   {
+      return b < a;
+   }
+   friend bool operator<=(const zip_iterator& a, const zip_iterator& b)
+   {
+      return !(b < a);
+   }
+   friend bool operator>=(const zip_iterator& a, const zip_iterator& b)
+   {
+      return !(a < b);
+   }
+
+ private:
+   std::tuple<Its...> its_;
+};
+
+template<class... Its> zip_iterator<Its...> make_zip_iterator(Its... its)
+{
+   return zip_iterator<Its...>(its...);
+}
+
+} // namespace learn_std
+
+// Structured bindings for zip_reference
+namespace std
+{
+template<class... Its>
+struct tuple_size<learn_std::zip_reference<Its...>>
+    : std::integral_constant<std::size_t, sizeof...(Its)>
+{};
+
+template<std::size_t I, class... Its>
+struct tuple_element<I, learn_std::zip_reference<Its...>>
+{
+   using type = std::tuple_element_t<
+       I,
+       std::tuple<typename std::iterator_traits<Its>::reference...>>;
+};
+} // namespace std
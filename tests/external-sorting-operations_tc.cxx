@@ -0,0 +1,185 @@
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "algorithms/external-sorting-operations.hxx"
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include "catch.hpp"
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+namespace
+{
+struct record
+{
+   std::uint32_t key;
+   char payload[20];
+};
+
+template<class T> void write_file(const std::string& path, const vector<T>& u)
+{
+   auto f = std::fopen(path.c_str(), "wb");
+   CATCH_REQUIRE(f != nullptr);
+   CATCH_REQUIRE(std::fwrite(u.data(), sizeof(T), u.size(), f) == u.size());
+   std::fclose(f);
+}
+
+template<class T> vector<T> read_file(const std::string& path)
+{
+   vector<T> u;
+   auto f = std::fopen(path.c_str(), "rb");
+   CATCH_REQUIRE(f != nullptr);
+   T x;
+   while(std::fread(&x, sizeof(T), 1, f) == 1) u.push_back(x);
+   std::fclose(f);
+   return u;
+}
+} // namespace
+
+CATCH_TEST_CASE("ExternalSortingOperations_", "[external-sorting-operations]")
+{
+   std::mt19937 g;
+   g.seed(1);
+
+   const std::string dir = P_tmpdir;
+   const auto in_path    = dir + "/learn_std-external-sort-tc-in";
+   const auto out_path   = dir + "/learn_std-external-sort-tc-out";
+
+   //
+   // ------------------------------------------------------------ external-sort
+   //
+   CATCH_SECTION("external-sort")
+   {
+      { // Typed records, from a file and from memory. The budgets range
+        // from everything in one chunk to many runs merged in several
+        // passes.
+         for(auto n : {0, 1, 1000, 40000}) {
+            auto u = vector<std::uint64_t>(std::size_t(n));
+            for(auto& x : u) x = g() % 100000;
+            write_file(in_path, u);
+            auto v = u;
+            std::sort(begin(v), end(v));
+
+            for(std::size_t budget : {1u << 12, 1u << 16, 1u << 20}) {
+               learn_std::external_sort<std::uint64_t>(
+                   in_path, out_path, std::less<>{}, budget);
+               CATCH_REQUIRE(read_file<std::uint64_t>(out_path) == v);
+
+               learn_std::external_sort(u.data(),
+                                        u.data() + u.size(),
+                                        out_path,
+                                        std::greater<>{},
+                                        budget,
+                                        dir);
+               auto w = read_file<std::uint64_t>(out_path);
+               std::reverse(begin(w), end(w));
+               CATCH_REQUIRE(w == v);
+            }
+         }
+      }
+
+      { // Far more runs than are merged at once, and than there may be
+        // open files: the merges cascade
+         auto u = vector<std::uint64_t>(100000);
+         for(auto& x : u) x = g();
+         auto v = u;
+         std::sort(begin(v), end(v));
+
+         rlimit old_limit;
+         CATCH_REQUIRE(getrlimit(RLIMIT_NOFILE, &old_limit) == 0);
+         auto limit     = old_limit;
+         limit.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 64);
+         CATCH_REQUIRE(setrlimit(RLIMIT_NOFILE, &limit) == 0);
+         learn_std::external_sort(u.data(),
+                                  u.data() + u.size(),
+                                  out_path,
+                                  std::less<>{},
+                                  1 << 12,
+                                  dir);
+         setrlimit(RLIMIT_NOFILE, &old_limit);
+         CATCH_REQUIRE(read_file<std::uint64_t>(out_path) == v);
+      }
+
+      { // Raw records, compared by a key at the front of each
+         vector<record> u(20000);
+         for(auto i = 0u; i < u.size(); ++i) {
+            u[i].key = std::uint32_t(g() % 1000);
+            std::snprintf(u[i].payload, sizeof(u[i].payload), "%u", i);
+         }
+         write_file(in_path, u);
+
+         auto by_key = [](const unsigned char* a, const unsigned char* b) {
+            std::uint32_t x, y;
+            std::memcpy(&x, a, sizeof(x));
+            std::memcpy(&y, b, sizeof(y));
+            return x < y;
+         };
+
+         auto check = [&](const vector<record>& w) {
+            CATCH_REQUIRE(w.size() == u.size());
+            auto key_less = [](auto& a, auto& b) { return a.key < b.key; };
+            CATCH_REQUIRE(std::is_sorted(begin(w), end(w), key_less));
+            vector<bool> seen(u.size());
+            for(const auto& r : w) {
+               const auto i = std::size_t(std::stoul(r.payload));
+               CATCH_REQUIRE(u[i].key == r.key);
+               seen[i] = true;
+            }
+            CATCH_REQUIRE(std::all_of(
+                begin(seen), end(seen), [](bool x) { return x; }));
+         };
+
+         for(std::size_t budget : {1u << 12, 1u << 18, 1u << 22}) {
+            learn_std::external_sort(
+                in_path, out_path, sizeof(record), by_key, budget, dir);
+            check(read_file<record>(out_path));
+
+            learn_std::external_sort(u.data(),
+                                     u.size() * sizeof(record),
+                                     out_path,
+                                     sizeof(record),
+                                     by_key,
+                                     budget);
+            check(read_file<record>(out_path));
+         }
+      }
+
+      { // Errors
+         auto comp = [](const unsigned char* a, const unsigned char* b) {
+            return *a < *b;
+         };
+         write_file(in_path, vector<char>(10, 'x'));
+         CATCH_REQUIRE_THROWS_AS(
+             learn_std::external_sort(in_path, out_path, 3, comp, 1 << 10),
+             std::invalid_argument);
+         CATCH_REQUIRE_THROWS_AS(
+             learn_std::external_sort(in_path, out_path, 2, comp, 8),
+             std::invalid_argument);
+         CATCH_REQUIRE_THROWS_AS(
+             learn_std::external_sort(
+                 dir + "/no/such/file", out_path, 2, comp, 1 << 10),
+             std::system_error);
+         CATCH_REQUIRE_THROWS_AS(
+             learn_std::external_sort(
+                 in_path, out_path, 1, comp, 64, dir + "/no/such"),
+             std::system_error);
+      }
+
+      std::remove(in_path.c_str());
+      std::remove(out_path.c_str());
+   }
+}
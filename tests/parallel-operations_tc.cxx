@@ -0,0 +1,362 @@
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "algorithms/parallel-operations.hxx"
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include "catch.hpp"
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+CATCH_TEST_CASE("ParallelOperations_", "[parallel-operations]")
+{
+   std::mt19937 g;
+   g.seed(1);
+   std::uniform_int_distribution<int> uniform;
+   using pt = decltype(uniform)::param_type;
+
+   auto rand = [&](int low, int high) { return uniform(g, pt(low, high)); };
+
+   // Sorted, reversed, all equal, organ pipe, sawtooth, few distinct keys
+   // and random: the inputs every sort is tried on
+   auto build_patterns = [&](unsigned len) {
+      vector<vector<int>> patterns;
+      vector<int> u(len);
+      iota(begin(u), end(u), 0);
+      patterns.push_back(u);
+      std::reverse(begin(u), end(u));
+      patterns.push_back(u);
+      std::fill(begin(u), end(u), 7);
+      patterns.push_back(u);
+      for(auto i = 0u; i < len; ++i) u[i] = int(std::min(i, len - i));
+      patterns.push_back(u);
+      for(auto i = 0u; i < len; ++i) u[i] = int(i % 7);
+      patterns.push_back(u);
+      for(auto& x : u) x = rand(0, 3);
+      patterns.push_back(u);
+      for(auto& x : u) x = rand(0, 1000000);
+      patterns.push_back(u);
+      return patterns;
+   };
+
+   //
+   // ------------------------------------------------------- execution-policy
+   //
+   CATCH_SECTION("execution-policy")
+   {
+      using namespace learn_std;
+      CATCH_REQUIRE(is_execution_policy_v<execution::sequenced_policy>);
+      CATCH_REQUIRE(is_execution_policy_v<execution::parallel_policy>);
+      CATCH_REQUIRE(
+          is_execution_policy_v<execution::parallel_unsequenced_policy>);
+      CATCH_REQUIRE(!is_execution_policy_v<int>);
+   }
+
+   //
+   // --------------------------------------------------------------------- sort
+   //
+   CATCH_SECTION("sort")
+   {
+      g.seed(1);
+
+      auto test_it = [&](const std::vector<int>& u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+
+         auto w = u;
+         learn_std::sort(learn_std::execution::seq, begin(w), end(w));
+         CATCH_REQUIRE(w == v);
+
+         w = u;
+         learn_std::sort(learn_std::execution::par, begin(w), end(w));
+         CATCH_REQUIRE(w == v);
+
+         w = u;
+         learn_std::sort(
+             learn_std::execution::parallel_policy{7}, begin(w), end(w));
+         CATCH_REQUIRE(w == v);
+
+         w = u;
+         learn_std::sort(learn_std::execution::parallel_unsequenced_policy{4},
+                         begin(w),
+                         end(w),
+                         std::greater<int>{});
+         CATCH_REQUIRE(std::is_sorted(rbegin(w), rend(w)));
+      };
+
+      for(auto len : {0u, 1u, 1000u, 100000u, 300000u})
+         for(auto& u : build_patterns(len)) test_it(u);
+
+      { // exceptions in a task reach the caller
+         std::vector<int> u(100000);
+         iota(begin(u), end(u), 0);
+         std::shuffle(begin(u), end(u), g);
+         auto throwing = [](int a, int b) {
+            if(a == 4242 or b == 4242) throw std::runtime_error("comp");
+            return a < b;
+         };
+         CATCH_REQUIRE_THROWS_AS(
+             learn_std::sort(learn_std::execution::parallel_policy{4},
+                             begin(u),
+                             end(u),
+                             throwing),
+             std::runtime_error);
+      }
+   }
+
+   //
+   // -------------------------------------------------------------------- merge
+   //
+   CATCH_SECTION("merge")
+   {
+      g.seed(1);
+
+      // Few distinct keys, tagged with their position, so stability shows
+      using kv    = std::pair<int, int>;
+      auto by_key = [](const kv& a, const kv& b) { return a.first < b.first; };
+      auto make   = [&](int n, int tag) {
+         std::vector<kv> u(std::size_t(n), kv(0, 0));
+         for(auto i = 0; i < n; ++i)
+            u[std::size_t(i)] = kv(rand(0, 50), tag + i);
+         std::sort(begin(u), end(u), by_key);
+         return u;
+      };
+
+      for(auto [n1, n2] : {std::pair(0, 0),
+                           std::pair(0, 100000),
+                           std::pair(1, 200000),
+                           std::pair(1000, 1000),
+                           std::pair(150000, 100000),
+                           std::pair(300000, 7)}) {
+         const auto a = make(n1, 0);
+         const auto b = make(n2, 1000000);
+         std::vector<kv> v(a.size() + b.size());
+         std::merge(begin(a), end(a), begin(b), end(b), begin(v), by_key);
+
+         for(auto threads : {1u, 2u, 7u}) {
+            std::vector<kv> w(v.size());
+            auto last = learn_std::merge(
+                learn_std::execution::parallel_policy{threads},
+                begin(a),
+                end(a),
+                begin(b),
+                end(b),
+                begin(w),
+                by_key);
+            CATCH_REQUIRE(last == end(w));
+            CATCH_REQUIRE(w == v);
+         }
+
+         // Default comparison, on the keys alone
+         auto keys = [](const std::vector<kv>& u) {
+            std::vector<int> k;
+            for(const auto& x : u) k.push_back(x.first);
+            return k;
+         };
+         const auto ka = keys(a);
+         const auto kb = keys(b);
+         std::vector<int> w(v.size());
+         learn_std::merge(learn_std::execution::par,
+                          begin(ka),
+                          end(ka),
+                          begin(kb),
+                          end(kb),
+                          begin(w));
+         CATCH_REQUIRE(w == keys(v));
+      }
+   }
+
+   //
+   // ------------------------------------------------------------ inplace-merge
+   //
+   CATCH_SECTION("inplace-merge")
+   {
+      g.seed(1);
+
+      auto test_it = [&](std::vector<std::string> u, long mid, auto comp) {
+         std::sort(begin(u), begin(u) + mid, comp);
+         std::sort(begin(u) + mid, end(u), comp);
+         auto v = u;
+         std::inplace_merge(begin(v), begin(v) + mid, end(v), comp);
+
+         for(auto threads : {1u, 2u, 7u}) {
+            auto w = u;
+            learn_std::inplace_merge(
+                learn_std::execution::parallel_policy{threads},
+                begin(w),
+                begin(w) + mid,
+                end(w),
+                comp);
+            CATCH_REQUIRE(w == v);
+         }
+      };
+
+      // Strings, compared by their first character only, so that equal
+      // elements can be told apart
+      auto by_first = [](const std::string& a, const std::string& b) {
+         return a.front() < b.front();
+      };
+      for(auto len : {0l, 1l, 1000l, 100000l}) {
+         auto u = std::vector<std::string>(std::size_t(len));
+         for(auto& s : u) s = std::to_string(rand(0, 1000000));
+         for(auto mid : {0l, 1l, len / 3, len / 2, len - 1, len}) {
+            if(mid < 0 or mid > len) continue;
+            test_it(u, mid, by_first);
+            test_it(u, mid, std::greater<>{});
+         }
+      }
+
+      { // Default comparison
+         std::vector<int> u(100000);
+         for(auto& x : u) x = rand(0, 1000);
+         std::sort(begin(u), begin(u) + 40000);
+         std::sort(begin(u) + 40000, end(u));
+         learn_std::inplace_merge(
+             learn_std::execution::par, begin(u), begin(u) + 40000, end(u));
+         CATCH_REQUIRE(std::is_sorted(begin(u), end(u)));
+      }
+   }
+
+   //
+   // -------------------------------------------------------------- stable-sort
+   //
+   CATCH_SECTION("stable-sort")
+   {
+      g.seed(1);
+
+      // Few distinct keys, tagged with their position, so stability shows
+      using kv    = std::pair<int, int>;
+      auto by_key = [](const kv& a, const kv& b) { return a.first < b.first; };
+
+      for(auto len : {0, 1, 1000, 100000}) {
+         std::vector<kv> u(std::size_t(len), kv(0, 0));
+         for(auto i = 0; i < len; ++i) u[std::size_t(i)] = kv(rand(0, 100), i);
+         auto v = u;
+         std::stable_sort(begin(v), end(v), by_key);
+
+         // Budgets from nothing, through part of one merge, to unlimited
+         const std::size_t n = u.size() * sizeof(kv);
+         for(auto budget : {std::size_t(0), n / 8, n / 2, n}) {
+            for(auto threads : {1u, 2u, 3u, 7u}) {
+               auto w = u;
+               learn_std::stable_sort(
+                   learn_std::execution::parallel_policy{threads},
+                   begin(w),
+                   end(w),
+                   by_key,
+                   budget);
+               CATCH_REQUIRE(w == v);
+            }
+         }
+
+         auto w = u;
+         learn_std::stable_sort(learn_std::execution::par, begin(w), end(w));
+         std::sort(begin(v), end(v));
+         CATCH_REQUIRE(w == v);
+      }
+
+      { // Strings, descending
+         std::vector<std::string> u(50000);
+         for(auto& s : u) s = std::to_string(rand(0, 1000000));
+         auto v = u;
+         std::stable_sort(begin(v), end(v), std::greater<>{});
+         learn_std::stable_sort(learn_std::execution::parallel_policy{4},
+                                begin(u),
+                                end(u),
+                                std::greater<>{});
+         CATCH_REQUIRE(u == v);
+      }
+   }
+
+   //
+   // -------------------------------------------------------------- sample-sort
+   //
+   CATCH_SECTION("sample-sort")
+   {
+      g.seed(1);
+
+      auto test_it = [&](const std::vector<int>& u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+         for(auto threads : {1u, 2u, 3u, 8u, 64u}) {
+            auto w = u;
+            learn_std::sample_sort(
+                begin(w), end(w), [](int a, int b) { return a < b; }, threads);
+            CATCH_REQUIRE(w == v);
+         }
+
+         auto w = u; // raw pointers
+         learn_std::sample_sort(w.data(), w.data() + w.size());
+         CATCH_REQUIRE(w == v);
+      };
+
+      for(auto len : {0u, 1u, 1000u, 100000u}) {
+         for(auto& u : build_patterns(len)) test_it(u);
+         std::vector<int> u(len);
+         for(auto& x : u) x = rand(0, 9) == 0 ? rand(0, 1000000) : 500000;
+         test_it(u); // one key dominates, with others either side
+      }
+
+      { // strings, descending
+         std::vector<std::string> u(50000);
+         for(auto& s : u) s = std::to_string(rand(0, 1000000));
+         auto v = u;
+         std::sort(begin(v), end(v), std::greater<>{});
+         learn_std::sample_sort(begin(u), end(u), std::greater<>{}, 4);
+         CATCH_REQUIRE(u == v);
+      }
+   }
+
+   //
+   // ----------------------------------------------------------- segmented-sort
+   //
+   CATCH_SECTION("segmented-sort")
+   {
+      g.seed(1);
+
+      for(auto segments : {0, 1, 3, 20000}) {
+         std::vector<std::size_t> offsets{0};
+         for(auto i = 0; i < segments; ++i) {
+            const auto n = rand(0, 9) < 8 ? rand(0, 40) : rand(0, 20000);
+            offsets.push_back(offsets.back() + std::size_t(n));
+         }
+         std::vector<int> u(offsets.back());
+         for(auto& x : u) x = rand(0, 1000000);
+
+         auto v = u;
+         learn_std::segmented_sort(
+             begin(v), end(v), begin(offsets), end(offsets));
+
+         for(auto threads : {1u, 2u, 7u}) {
+            auto w = u;
+            learn_std::segmented_sort(
+                learn_std::execution::parallel_policy{threads},
+                begin(w),
+                end(w),
+                begin(offsets),
+                end(offsets));
+            CATCH_REQUIRE(w == v);
+         }
+
+         auto w = u;
+         learn_std::segmented_sort(learn_std::execution::par,
+                                   begin(w),
+                                   end(w),
+                                   begin(offsets),
+                                   end(offsets),
+                                   std::greater<>{});
+         for(auto i = 0u; i + 1 < offsets.size(); ++i)
+            CATCH_REQUIRE(std::is_sorted(begin(w) + long(offsets[i]),
+                                         begin(w) + long(offsets[i + 1]),
+                                         std::greater<>{}));
+      }
+   }
+}
@@ -0,0 +1,210 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "algorithms/simd-operations.hxx"
+#include "algorithms/sorting-operations.hxx"
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include "catch.hpp"
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+CATCH_TEST_CASE("SimdOperations_", "[simd-operations]")
+{
+   std::mt19937 g;
+   g.seed(1);
+
+   //
+   // ---------------------------------------------------------------- simd-sort
+   //
+   CATCH_SECTION("simd-sort")
+   {
+      using namespace learn_std::detail;
+      using int_it = vector<int>::iterator;
+      CATCH_REQUIRE(is_simd_sort_candidate_v<int_it, std::less<>>);
+      CATCH_REQUIRE(is_simd_sort_candidate_v<int_it, std::less<int>>);
+      CATCH_REQUIRE(is_simd_sort_candidate_v<double*, std::less<>>);
+      CATCH_REQUIRE(!is_simd_sort_candidate_v<int_it, std::greater<>>);
+      CATCH_REQUIRE(!is_simd_sort_candidate_v<int_it, std::less<long>>);
+      CATCH_REQUIRE(!is_simd_sort_candidate_v<short*, std::less<>>);
+      CATCH_REQUIRE(!is_simd_sort_candidate_v<long double*, std::less<>>);
+      CATCH_REQUIRE(
+          !is_simd_sort_candidate_v<std::deque<int>::iterator, std::less<>>);
+
+      auto test_type = [&](auto zero) {
+         using T = decltype(zero);
+         using lim = std::numeric_limits<T>;
+
+         auto random_key = [&]() -> T {
+            if constexpr(std::is_floating_point_v<T>)
+               return std::uniform_real_distribution<T>(-1e6, 1e6)(g);
+            else
+               return std::uniform_int_distribution<T>(lim::lowest(),
+                                                       lim::max())(g);
+         };
+
+         auto test_it = [&](const vector<T>& u) {
+            auto v = u;
+            std::sort(begin(v), end(v));
+
+            auto negative_zeros = [](const vector<T>& x) {
+               return std::count_if(begin(x), end(x), [](T k) {
+                  return k == T(0) and std::signbit(double(k));
+               });
+            };
+
+            auto w = u;
+            learn_std::sort(begin(w), end(w));
+            CATCH_REQUIRE(w == v);
+            CATCH_REQUIRE(negative_zeros(w) == negative_zeros(u));
+
+#if LEARN_STD_X86_SIMD
+            const auto n = int(u.size());
+            if(__builtin_cpu_supports("avx2")) {
+               w = u;
+               simd_quicksort<simd_isa::avx2>(w.data(), w.data() + n, 64);
+               CATCH_REQUIRE(w == v);
+               CATCH_REQUIRE(negative_zeros(w) == negative_zeros(u));
+
+               // Heapsort fallback
+               w = u;
+               simd_quicksort<simd_isa::avx2>(w.data(), w.data() + n, 0);
+               CATCH_REQUIRE(w == v);
+            }
+            if(__builtin_cpu_supports("avx512f")) {
+               w = u;
+               simd_quicksort<simd_isa::avx512>(w.data(), w.data() + n, 64);
+               CATCH_REQUIRE(w == v);
+               CATCH_REQUIRE(negative_zeros(w) == negative_zeros(u));
+
+               w = u;
+               simd_quicksort<simd_isa::avx512>(w.data(), w.data() + n, 0);
+               CATCH_REQUIRE(w == v);
+            }
+#endif
+         };
+
+         const auto specials = std::is_floating_point_v<T>
+                                   ? vector<T>{T(0),
+                                               -T(0),
+                                               lim::infinity(),
+                                               -lim::infinity(),
+                                               lim::max(),
+                                               lim::lowest(),
+                                               lim::denorm_min()}
+                                   : vector<T>{T(0), lim::max(), lim::lowest()};
+
+         for(auto n : {0,   1,   2,   3,   7,   8,   15,  16,   17,   31,
+                       32,  33,  63,  64,  65,  100, 127, 128,  129,  255,
+                       256, 257, 513, 777, 1000, 4099, 100000}) {
+            auto u = vector<T>(std::size_t(n));
+
+            for(auto& x : u) x = random_key();
+            test_it(u);
+
+            for(auto& x : u) x = specials[g() % specials.size()];
+            test_it(u);
+
+            for(auto& x : u) x = T(g() % 4);
+            test_it(u);
+
+            // Mostly the smallest key, which then tends to be the pivot
+            for(auto& x : u) x = g() % 5 < 3 ? T(0) : T(1 + g() % 1000);
+            test_it(u);
+
+            std::fill(begin(u), end(u), T(7));
+            test_it(u);
+
+            for(auto i = 0; i < n; ++i) u[std::size_t(i)] = T(i);
+            test_it(u);
+
+            std::reverse(begin(u), end(u));
+            test_it(u);
+
+            for(auto i = 0; i < n; ++i)
+               u[std::size_t(i)] = T(std::min(i, n - i));
+            test_it(u);
+
+            for(auto i = 0; i < n; ++i) u[std::size_t(i)] = T(i % 17);
+            test_it(u);
+         }
+      };
+
+      test_type(std::int32_t(0));
+      test_type(std::uint32_t(0));
+      test_type(std::int64_t(0));
+      test_type(std::uint64_t(0));
+      test_type(float(0));
+      test_type(double(0));
+
+      { // Raw pointers take the same path
+         vector<unsigned> u(5000);
+         for(auto& x : u) x = unsigned(g());
+         auto v = u;
+         std::sort(begin(v), end(v));
+         learn_std::sort(u.data(), u.data() + u.size(), std::less<unsigned>{});
+         CATCH_REQUIRE(u == v);
+      }
+
+      { // NaNs leave the order unspecified, but no key is lost
+         vector<double> u(3000);
+         for(auto i = 0u; i < u.size(); ++i)
+            u[i] = i % 5 == 0 ? std::nan("") : double(g() % 100);
+         auto w = u;
+         learn_std::sort(begin(w), end(w));
+         auto nans = [](const vector<double>& x) {
+            return std::count_if(
+                begin(x), end(x), [](double k) { return std::isnan(k); });
+         };
+         CATCH_REQUIRE(nans(w) == nans(u));
+      }
+   }
+
+   //
+   // --------------------------------------------------------- simd-find-before
+   //
+   CATCH_SECTION("simd-find-before")
+   {
+      using learn_std::detail::simd_find_before;
+
+      auto test_type = [&](auto zero) {
+         using T = decltype(zero);
+         for(auto n : {0, 1, 5, 8, 16, 31, 64, 65, 200, 1000}) {
+            auto u = vector<T>(std::size_t(n));
+            for(auto& x : u) x = T(g() % 50 + 10);
+            for(auto r = 0; r < 10; ++r) {
+               // Plant a key past the bound, or none at all
+               auto w = u;
+               if(n > 0 and r % 3 != 0) w[g() % w.size()] = T(r % 2 ? 3 : 90);
+               const auto first = w.data();
+               const auto last  = w.data() + n;
+
+               auto lo = std::find_if(first, last, [](T x) { return x < 5; });
+               auto hi = std::find_if(first, last, [](T x) { return x > 80; });
+               using less    = std::less<>;
+               using greater = std::greater<T>;
+               CATCH_REQUIRE(simd_find_before<less>(first, last, T(5)) == lo);
+               CATCH_REQUIRE(simd_find_before<greater>(first, last, T(80))
+                             == hi);
+            }
+         }
+      };
+
+      test_type(std::int32_t(0));
+      test_type(std::uint32_t(0));
+      test_type(std::int64_t(0));
+      test_type(std::uint64_t(0));
+      test_type(float(0));
+      test_type(double(0));
+   }
+}
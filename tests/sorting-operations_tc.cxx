@@ -1,7 +1,17 @@
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
 #include <numeric>
+#include <sstream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "algorithms/sorting-operations.hxx"
@@ -22,6 +32,28 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
 
    auto rand = [&](int low, int high) { return uniform(g, pt(low, high)); };
 
+   // Sorted, reversed, all equal, organ pipe, sawtooth, few distinct keys
+   // and random: the inputs every sort is tried on
+   auto build_patterns = [&](unsigned len) {
+      vector<vector<int>> patterns;
+      vector<int> u(len);
+      iota(begin(u), end(u), 0);
+      patterns.push_back(u);
+      std::reverse(begin(u), end(u));
+      patterns.push_back(u);
+      std::fill(begin(u), end(u), 7);
+      patterns.push_back(u);
+      for(auto i = 0u; i < len; ++i) u[i] = int(std::min(i, len - i));
+      patterns.push_back(u);
+      for(auto i = 0u; i < len; ++i) u[i] = int(i % 7);
+      patterns.push_back(u);
+      for(auto& x : u) x = rand(0, 3);
+      patterns.push_back(u);
+      for(auto& x : u) x = rand(0, 1000000);
+      patterns.push_back(u);
+      return patterns;
+   };
+
    //
    // ------------------------------------------------- is-sorted-is-sorted-util
    //
@@ -51,6 +83,227 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
          for(auto n = 0u; n < l; ++n) test_it(build_u(l, n), n);
    }
 
+   //
+   // -------------------------------------------------------------------- merge
+   //
+   CATCH_SECTION("merge")
+   {
+      // Equal keys from the first range go first
+      using kv    = std::pair<int, char>;
+      auto by_key = [](const kv& a, const kv& b) { return a.first < b.first; };
+      const vector<kv> a{{1, 'a'}, {2, 'a'}, {2, 'a'}, {5, 'a'}};
+      const vector<kv> b{{0, 'b'}, {2, 'b'}, {5, 'b'}, {6, 'b'}};
+      vector<kv> out(a.size() + b.size());
+      auto last = learn_std::merge(
+          begin(a), end(a), begin(b), end(b), begin(out), by_key);
+      CATCH_REQUIRE(last == end(out));
+      CATCH_REQUIRE(out
+                    == vector<kv>{{0, 'b'},
+                                  {1, 'a'},
+                                  {2, 'a'},
+                                  {2, 'a'},
+                                  {2, 'b'},
+                                  {5, 'a'},
+                                  {5, 'b'},
+                                  {6, 'b'}});
+
+      vector<int> c{1, 3, 5};
+      vector<int> d{2, 4};
+      vector<int> e;
+      learn_std::merge(
+          begin(c), end(c), begin(d), end(d), std::back_inserter(e));
+      CATCH_REQUIRE(e == vector<int>{1, 2, 3, 4, 5});
+
+      // Numbers in vectors take the branchless loop and memmove the tails
+      auto test_it = [&](int n1, int n2, auto comp) {
+         auto u = vector<double>(std::size_t(n1));
+         auto v = vector<double>(std::size_t(n2));
+         for(auto& x : u) x = rand(0, 100);
+         for(auto& x : v) x = rand(0, 100);
+         std::sort(begin(u), end(u), comp);
+         std::sort(begin(v), end(v), comp);
+         auto expect = vector<double>(u.size() + v.size());
+         std::merge(begin(u), end(u), begin(v), end(v), begin(expect), comp);
+         auto out  = vector<double>(expect.size());
+         auto last = learn_std::merge(
+             begin(u), end(u), begin(v), end(v), out.data(), comp);
+         CATCH_REQUIRE(last == out.data() + out.size());
+         CATCH_REQUIRE(out == expect);
+      };
+      for(auto [n1, n2] : {std::pair(0, 0),
+                           std::pair(0, 5),
+                           std::pair(5, 0),
+                           std::pair(1, 1000),
+                           std::pair(1000, 1),
+                           std::pair(1000, 1000)}) {
+         test_it(n1, n2, std::less<>{});
+         test_it(n1, n2, std::greater<>{});
+      }
+
+      { // Skewed sizes gallop: stable, and few comparisons
+         using kv     = std::pair<int, int>;
+         long n_comps = 0;
+         auto by_key  = [&](const kv& x, const kv& y) {
+            ++n_comps;
+            return x.first < y.first;
+         };
+         auto make = [&](int n, int tag) {
+            auto u = vector<kv>(std::size_t(n));
+            for(auto i = 0; i < n; ++i) u[std::size_t(i)] = kv(rand(0, n), tag);
+            std::sort(begin(u), end(u));
+            return u;
+         };
+         for(auto [n1, n2] : {std::pair(100000, 10),
+                              std::pair(10, 100000),
+                              std::pair(5000, 5000)}) {
+            const auto u = make(n1, 1);
+            const auto v = make(n2, 2);
+            auto expect  = vector<kv>(u.size() + v.size());
+            std::merge(
+                begin(u), end(u), begin(v), end(v), begin(expect), by_key);
+            auto out = vector<kv>(expect.size());
+            n_comps  = 0;
+            learn_std::merge(
+                begin(u), end(u), begin(v), end(v), begin(out), by_key);
+            CATCH_REQUIRE(out == expect);
+            if(std::min(n1, n2) == 10) CATCH_REQUIRE(n_comps < 1000);
+
+            // Not random access: no galloping, same result
+            std::list<kv> l(begin(v), end(v));
+            std::fill(begin(out), end(out), kv(0, 0));
+            learn_std::merge(
+                begin(u), end(u), begin(l), end(l), begin(out), by_key);
+            CATCH_REQUIRE(out == expect);
+         }
+      }
+
+      { // Into another value type: the tails convert, not memmove
+         const vector<int> u{1, 3, 5, 7, 9, 11, 12};
+         const vector<int> v{2, 4, 6};
+         auto out  = vector<long long>(u.size() + v.size());
+         auto last = learn_std::merge(
+             begin(u), end(u), begin(v), end(v), out.data());
+         CATCH_REQUIRE(last == out.data() + out.size());
+         CATCH_REQUIRE(out
+                       == vector<long long>{1, 2, 3, 4, 5, 6, 7, 9, 11, 12});
+
+         const vector<float> f{0.5f, 1.5f, 2.5f, 3.5f};
+         const vector<float> h{1.0f};
+         auto d = vector<double>(f.size() + h.size());
+         learn_std::merge(begin(f), end(f), begin(h), end(h), d.data());
+         CATCH_REQUIRE(d == vector<double>{0.5, 1.0, 1.5, 2.5, 3.5});
+      }
+   }
+
+   //
+   // --------------------------------------------------------------- move-merge
+   //
+   CATCH_SECTION("move-merge")
+   {
+      // Move-only elements
+      auto make = [](std::initializer_list<int> keys) {
+         vector<std::unique_ptr<int>> u;
+         for(auto k : keys) u.push_back(std::make_unique<int>(k));
+         return u;
+      };
+      auto a     = make({1, 4, 4, 9});
+      auto b     = make({0, 4, 10});
+      auto a4    = a[1].get();
+      auto deref = [](const auto& x, const auto& y) { return *x < *y; };
+      vector<std::unique_ptr<int>> out(a.size() + b.size());
+      auto last = learn_std::move_merge(
+          begin(a), end(a), begin(b), end(b), begin(out), deref);
+      CATCH_REQUIRE(last == end(out));
+      vector<int> keys;
+      for(const auto& p : out) keys.push_back(*p);
+      CATCH_REQUIRE(keys == vector<int>{0, 1, 4, 4, 4, 9, 10});
+      CATCH_REQUIRE(out[2].get() == a4); // stable
+      CATCH_REQUIRE(std::none_of(
+          begin(a), end(a), [](const auto& p) { return bool(p); }));
+
+      // Strings are moved, not copied
+      vector<std::string> s{std::string(100, 'a'), std::string(100, 'c')};
+      vector<std::string> t{std::string(100, 'b')};
+      const auto* data = s[1].data();
+      vector<std::string> merged;
+      learn_std::move_merge(
+          begin(s), end(s), begin(t), end(t), std::back_inserter(merged));
+      CATCH_REQUIRE(merged.size() == 3);
+      CATCH_REQUIRE(merged[2].data() == data);
+      CATCH_REQUIRE(std::is_sorted(begin(merged), end(merged)));
+   }
+
+   //
+   // ----------------------------------------------------------- multiway-merge
+   //
+   CATCH_SECTION("multiway-merge")
+   {
+      // Keys with many ties, and values that record the range and position
+      // of each element, so that stability shows
+      using kv     = std::pair<int, int>;
+      auto by_key  = [](const kv& a, const kv& b) { return a.first < b.first; };
+      auto make_ks = [&](unsigned k) {
+         vector<vector<kv>> ranges(k);
+         for(auto i = 0u; i < k; ++i) {
+            auto& r = ranges[i];
+            r.resize(g() % 4 == 0 ? 0u : g() % 50);
+            for(auto j = 0u; j < r.size(); ++j)
+               r[j] = kv(int(g() % 20), int(i * 1000 + j));
+            std::sort(begin(r), end(r), by_key);
+         }
+         return ranges;
+      };
+
+      for(auto k : {0u, 1u, 2u, 3u, 5u, 16u, 256u}) {
+         auto ranges = make_ks(k);
+         vector<kv> expect;
+         for(const auto& r : ranges)
+            expect.insert(end(expect), begin(r), end(r));
+         std::stable_sort(begin(expect), end(expect), by_key);
+
+         { // Containers as ranges
+            vector<kv> out(expect.size());
+            auto last = learn_std::multiway_merge(
+                begin(ranges), end(ranges), begin(out), by_key);
+            CATCH_REQUIRE(last == end(out));
+            CATCH_REQUIRE(out == expect);
+         }
+
+         { // Iterator pairs into lists, and std::greater
+            vector<std::list<int>> lists(k);
+            vector<std::pair<std::list<int>::iterator,
+                             std::list<int>::iterator>>
+                pairs;
+            vector<int> keys;
+            for(auto i = 0u; i < k; ++i) {
+               for(const auto& x : ranges[i]) lists[i].push_front(x.first);
+               pairs.emplace_back(begin(lists[i]), end(lists[i]));
+               keys.insert(end(keys), begin(lists[i]), end(lists[i]));
+            }
+            std::sort(begin(keys), end(keys), std::greater<>{});
+            vector<int> out;
+            learn_std::multiway_merge(begin(pairs),
+                                      end(pairs),
+                                      std::back_inserter(out),
+                                      std::greater<>{});
+            CATCH_REQUIRE(out == keys);
+         }
+      }
+
+      { // Single-pass inputs
+         std::istringstream a("1 4 4 9");
+         std::istringstream b("");
+         std::istringstream c("0 4 5 10 11");
+         using It = std::istream_iterator<int>;
+         vector<std::pair<It, It>> streams{
+             {It(a), It()}, {It(b), It()}, {It(c), It()}};
+         vector<int> out;
+         learn_std::multiway_merge(
+             begin(streams), end(streams), std::back_inserter(out));
+         CATCH_REQUIRE(out == vector<int>{0, 1, 4, 4, 4, 5, 9, 10, 11});
+      }
+   }
+
    //
    // ------------------------------------------------------------ inplace-merge
    //
@@ -98,6 +351,47 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
                    build_u(l, i), i, [](auto& a, auto& b) { return a < b; });
                test_it(build_v(l, i), i, op);
             }
+
+      // Larger, skewed merges of (key, position) pairs
+      auto by_key = [](auto& a, auto& b) { return a.first < b.first; };
+      auto build_pairs = [&](unsigned len, unsigned n, int max_key) {
+         std::vector<std::pair<int, int>> u(len);
+         for(auto& x : u) x.first = rand(0, max_key);
+         std::sort(begin(u), begin(u) + n, by_key);
+         std::sort(begin(u) + n, end(u), by_key);
+         for(auto i = 0u; i < len; ++i) u[i].second = int(i);
+         return u;
+      };
+
+      auto test_pairs = [&](auto u, unsigned n) {
+         auto v = u;
+         std::stable_sort(begin(v), end(v), by_key);
+
+         auto w = u;
+         learn_std::inplace_merge(begin(w), begin(w) + n, end(w), by_key);
+         CATCH_REQUIRE(w == v);
+
+         // Bidirectional iterators
+         std::list<std::pair<int, int>> l(begin(u), end(u));
+         learn_std::inplace_merge(
+             begin(l), std::next(begin(l), n), end(l), by_key);
+         CATCH_REQUIRE(std::equal(begin(l), end(l), begin(v), end(v)));
+
+         // No buffer: SymMerge all the way down
+         w = u;
+         learn_std::detail::temporary_buffer<std::pair<int, int>> none(0);
+         std::ptrdiff_t min_gallop = learn_std::detail::k_min_gallop;
+         learn_std::detail::merge_adaptive(
+             begin(w), begin(w) + n, end(w), by_key, none, min_gallop);
+         CATCH_REQUIRE(w == v);
+      };
+
+      for(auto len : {2u, 50u, 1000u, 5000u})
+         for(auto n : {1u, 7u, len / 3, len / 2, len - 3, len - 1})
+            if(n < len)
+               for(auto max_key : {3, 1000000}) {
+                  test_pairs(build_pairs(len, n, max_key), n);
+               }
    }
 
    //
@@ -121,6 +415,375 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
 
       for(auto l = 0u; l <= 26; ++l)
          for(auto n = 0u; n < 100; ++n) test_it(build_u(l));
+
+      // Inputs that send a last-element pivot quadratic
+      auto test_pattern = [&](std::vector<int> u) {
+         auto v = u;
+         std::sort(begin(v), end(v), std::greater<int>{});
+         learn_std::sort(begin(u), end(u), std::greater<int>{});
+         CATCH_REQUIRE(u == v);
+      };
+
+      for(auto len : {17u, 100u, 129u, 1000u, 10000u})
+         for(auto& u : build_patterns(len)) test_pattern(u);
+   }
+
+   //
+   // ----------------------------------------------------------------- pdq-sort
+   //
+   CATCH_SECTION("pdq-sort")
+   {
+      g.seed(1);
+
+      auto test_it = [&](std::vector<int> u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+
+         // Block partitioning path
+         auto w = u;
+         learn_std::pdq_sort(begin(w), end(w));
+         CATCH_REQUIRE(w == v);
+
+         // Branchy path
+         w = u;
+         learn_std::pdq_sort(
+             begin(w), end(w), [](auto& a, auto& b) { return a < b; });
+         CATCH_REQUIRE(w == v);
+
+         // Non-arithmetic keys
+         std::vector<std::string> s(u.size()), t;
+         std::transform(begin(u), end(u), begin(s), [](int x) {
+            return std::to_string(x);
+         });
+         t = s;
+         std::sort(begin(t), end(t), std::greater<>{});
+         learn_std::pdq_sort(begin(s), end(s), std::greater<>{});
+         CATCH_REQUIRE(s == t);
+      };
+
+      for(auto len : {0u, 1u, 2u, 5u, 16u, 17u, 100u, 129u, 1000u, 10000u}) {
+         for(auto& u : build_patterns(len)) test_it(u);
+         std::vector<int> u(len);
+         for(auto r = 0; r < 10; ++r) {
+            for(auto& x : u) x = rand(0, 1000000);
+            test_it(u); // more random
+         }
+      }
+   }
+
+   //
+   // -------------------------------------------------------------- sort-unique
+   //
+   CATCH_SECTION("sort-unique")
+   {
+      g.seed(1);
+
+      auto test_it = [&](std::vector<int> u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+         v.erase(std::unique(begin(v), end(v)), end(v));
+
+         // Block partitioning path
+         auto w = u;
+         w.erase(learn_std::sort_unique(begin(w), end(w)), end(w));
+         CATCH_REQUIRE(w == v);
+
+         // Branchy path, duplicates by equivalence
+         w = u;
+         w.erase(learn_std::sort_unique(
+                     begin(w), end(w), [](auto& a, auto& b) { return a < b; }),
+                 end(w));
+         CATCH_REQUIRE(w == v);
+
+         // Non-arithmetic keys, and an eq that is coarser than comp
+         std::vector<std::string> s(u.size()), t;
+         std::transform(begin(u), end(u), begin(s), [](int x) {
+            return std::to_string(x);
+         });
+         auto same_first = [](auto& a, auto& b) { return a[0] == b[0]; };
+         t               = s;
+         std::sort(begin(t), end(t), std::greater<>{});
+         t.erase(std::unique(begin(t), end(t), same_first), end(t));
+         s.erase(learn_std::sort_unique(
+                     begin(s), end(s), std::greater<>{}, same_first),
+                 end(s));
+         CATCH_REQUIRE(s == t);
+      };
+
+      // Beyond the usual inputs, what sort_unique adds: duplicates at
+      // every density in between
+      for(auto len : {0u, 1u, 2u, 5u, 16u, 17u, 100u, 129u, 1000u, 10000u}) {
+         for(auto& u : build_patterns(len)) test_it(u);
+         std::vector<int> u(len);
+         for(auto span : {len / 8, len / 2, len, 4 * len}) {
+            for(auto& x : u) x = rand(0, int(span));
+            test_it(u); // random, with more duplicates the narrower
+         }
+      }
+
+      { // move-only
+         std::vector<std::unique_ptr<int>> u;
+         for(auto i = 0; i < 1000; ++i)
+            u.push_back(std::make_unique<int>(rand(0, 100)));
+         auto less = [](auto& a, auto& b) { return *a < *b; };
+         auto end  = learn_std::sort_unique(begin(u), std::end(u), less);
+         CATCH_REQUIRE(end - begin(u) == 101);
+         CATCH_REQUIRE(std::all_of(
+             begin(u), end, [](auto& p) { return p != nullptr; }));
+         CATCH_REQUIRE(std::adjacent_find(begin(u), end, [&](auto& a, auto& b) {
+                          return !less(a, b);
+                       })
+                       == end);
+      }
+   }
+
+   //
+   // --------------------------------------------------------------- radix-sort
+   //
+   CATCH_SECTION("radix-sort")
+   {
+      g.seed(1);
+
+      auto test_it = [&](auto u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+         learn_std::radix_sort(begin(u), end(u));
+         CATCH_REQUIRE(u == v);
+      };
+
+      for(auto len : {0u, 1u, 2u, 10u, 1000u}) {
+         std::vector<uint64_t> u64(len);
+         std::vector<int32_t> i32(len);
+         std::vector<int8_t> i8(len);
+         std::vector<double> f64(len);
+         std::vector<float> f32(len);
+         for(auto i = 0u; i < len; ++i) {
+            u64[i] = uint64_t(rand(0, 1 << 30)) << rand(0, 33);
+            i32[i] = rand(-1000000, 1000000);
+            i8[i]  = int8_t(rand(-128, 127));
+            f64[i] = rand(-1000000, 1000000) / 7.0;
+            f32[i] = float(rand(-1000000, 1000000)) * 1e-3f;
+         }
+         test_it(u64);
+         test_it(i32);
+         test_it(i8);
+         test_it(f64);
+         test_it(f32);
+
+         // every key equal: no passes at all
+         std::fill(begin(i32), end(i32), -5);
+         test_it(i32);
+      }
+
+      { // infinities and signed zero follow the total order
+         std::vector<double> u = {0.0, -1.5, HUGE_VAL, -0.0, -HUGE_VAL, 2.0};
+         learn_std::radix_sort(begin(u), end(u));
+         CATCH_REQUIRE(std::is_sorted(begin(u), end(u)));
+         CATCH_REQUIRE(std::signbit(u[2]));
+         CATCH_REQUIRE(!std::signbit(u[3]));
+      }
+
+      { // stable on a key extractor
+         std::vector<std::pair<int, int>> u(1000);
+         for(auto i = 0u; i < u.size(); ++i) u[i] = {rand(-50, 50), int(i)};
+         auto v = u;
+         auto key = [](const auto& x) { return x.first; };
+         std::stable_sort(begin(v), end(v), [&](auto& a, auto& b) {
+            return key(a) < key(b);
+         });
+         learn_std::radix_sort(begin(u), end(u), key);
+         CATCH_REQUIRE(u == v);
+      }
+
+      { // move-only, not default constructible
+         struct Item
+         {
+            explicit Item(int x)
+                : p(std::make_unique<int>(x))
+            {}
+            std::unique_ptr<int> p;
+         };
+         std::vector<Item> u;
+         for(auto i = 0; i < 100; ++i) u.emplace_back(rand(0, 1000));
+         learn_std::radix_sort(
+             begin(u), end(u), [](const Item& x) { return *x.p; });
+         CATCH_REQUIRE(std::is_sorted(
+             begin(u), end(u), [](auto& a, auto& b) { return *a.p < *b.p; }));
+      }
+   }
+
+   //
+   // -------------------------------------------------------- radix-sort-unique
+   //
+   CATCH_SECTION("radix-sort-unique")
+   {
+      g.seed(1);
+
+      auto test_it = [&](auto u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+         v.erase(std::unique(begin(v), end(v)), end(v));
+         u.erase(learn_std::radix_sort_unique(begin(u), end(u)), end(u));
+         CATCH_REQUIRE(u == v);
+      };
+
+      for(auto len : {0u, 1u, 2u, 10u, 1000u, 100000u}) {
+         std::vector<uint64_t> u64(len);
+         std::vector<int32_t> i32(len);
+         std::vector<int8_t> i8(len);
+         for(auto i = 0u; i < len; ++i) {
+            u64[i] = uint64_t(rand(0, int(len))) << rand(0, 1);
+            i32[i] = rand(-1000000, 1000000);
+            i8[i]  = int8_t(rand(-128, 127));
+         }
+         test_it(u64);
+         test_it(i32);
+         test_it(i8);
+
+         // every key equal: no passes at all
+         std::fill(begin(i32), end(i32), -5);
+         test_it(i32);
+
+         // only the lowest digit differs, so it's the last pass too
+         for(auto i = 0u; i < len; ++i) u64[i] = 0xabcd00 + uint64_t(i % 37);
+         test_it(u64);
+      }
+
+      { // stable: the first element with each key is kept
+         std::vector<std::pair<int, int>> u(1000);
+         for(auto i = 0u; i < u.size(); ++i) u[i] = {rand(-50, 50), int(i)};
+         auto v   = u;
+         auto key = [](const auto& x) { return x.first; };
+         auto eq  = [&](auto& a, auto& b) { return key(a) == key(b); };
+         std::stable_sort(begin(v), end(v), [&](auto& a, auto& b) {
+            return key(a) < key(b);
+         });
+         v.erase(std::unique(begin(v), end(v), eq), end(v));
+         u.erase(learn_std::radix_sort_unique(begin(u), end(u), key), end(u));
+         CATCH_REQUIRE(u == v);
+      }
+
+      { // move-only, not default constructible
+         struct Item
+         {
+            explicit Item(int x)
+                : p(std::make_unique<int>(x))
+            {}
+            std::unique_ptr<int> p;
+         };
+         std::vector<Item> u;
+         for(auto i = 0; i < 1000; ++i) u.emplace_back(rand(0, 300));
+         auto key = [](const Item& x) { return *x.p; };
+         std::vector<int> v, w;
+         std::transform(begin(u), end(u), std::back_inserter(v), key);
+         std::sort(begin(v), end(v));
+         v.erase(std::unique(begin(v), end(v)), end(v));
+         auto last = learn_std::radix_sort_unique(begin(u), end(u), key);
+         std::transform(begin(u), last, std::back_inserter(w), key);
+         CATCH_REQUIRE(w == v);
+      }
+   }
+
+   //
+   // ----------------------------------------------------------- msd-radix-sort
+   //
+   CATCH_SECTION("msd-radix-sort")
+   {
+      g.seed(1);
+
+      auto test_it = [&](auto u) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+         learn_std::msd_radix_sort(begin(u), end(u));
+         CATCH_REQUIRE(u == v);
+      };
+
+      for(auto len : {0u, 1u, 2u, 63u, 64u, 1000u, 20000u}) {
+         std::vector<uint64_t> u64(len);
+         std::vector<int32_t> i32(len);
+         std::vector<int16_t> i16(len);
+         std::vector<float> f32(len);
+         for(auto i = 0u; i < len; ++i) {
+            u64[i] = uint64_t(rand(0, 1 << 30)) << rand(0, 33);
+            i32[i] = rand(-1000000, 1000000);
+            i16[i] = int16_t(rand(-3, 3)); // deep runs of equal keys
+            f32[i] = float(rand(-1000000, 1000000)) * 1e-3f;
+         }
+         test_it(u64);
+         test_it(i32);
+         test_it(i16);
+         test_it(f32);
+      }
+
+      { // 32-byte records sorted on an extracted key
+         struct Record
+         {
+            uint64_t id;
+            char payload[24];
+         };
+         std::vector<Record> u(5000);
+         for(auto& r : u) {
+            r.id = uint64_t(rand(0, 1 << 20)) << 20 | uint64_t(rand(0, 99));
+            std::fill(std::begin(r.payload), std::end(r.payload), char(r.id));
+         }
+         learn_std::msd_radix_sort(
+             begin(u), end(u), [](const Record& r) { return r.id; });
+         CATCH_REQUIRE(std::is_sorted(
+             begin(u), end(u), [](auto& a, auto& b) { return a.id < b.id; }));
+         CATCH_REQUIRE(std::all_of(begin(u), end(u), [](auto& r) {
+            return r.payload[23] == char(r.id);
+         }));
+      }
+   }
+
+   //
+   // -------------------------------------------------------------- string-sort
+   //
+   CATCH_SECTION("string-sort")
+   {
+      g.seed(1);
+
+      // Paths with long shared prefixes
+      auto build_u = [&](unsigned len) {
+         std::vector<std::string> u(len);
+         for(auto& s : u) {
+            s = "/usr/share/";
+            for(auto n = rand(0, 12); n > 0; --n) s += char(rand('a', 'd'));
+         }
+         return u;
+      };
+
+      for(auto len : {0u, 1u, 2u, 16u, 17u, 100u, 5000u}) {
+         auto u = build_u(len);
+         u.push_back(std::string("ab\0c", 4)); // embedded nul
+         u.push_back(std::string("ab", 2));
+         u.push_back("");
+         auto v = u;
+         std::sort(begin(v), end(v));
+
+         { // std::string
+            auto w = u;
+            learn_std::string_sort(begin(w), end(w));
+            CATCH_REQUIRE(w == v);
+         }
+
+         { // std::string_view
+            std::vector<std::string_view> w(begin(u), end(u));
+            learn_std::string_sort(begin(w), end(w));
+            CATCH_REQUIRE(std::equal(begin(w), end(w), begin(v), end(v)));
+         }
+
+         { // nul-terminated
+            std::vector<const char*> w(u.size());
+            std::transform(begin(u), end(u), begin(w), [](auto& s) {
+               return s.c_str();
+            });
+            learn_std::string_sort(begin(w), end(w));
+            CATCH_REQUIRE(std::is_sorted(begin(w), end(w), [](auto a, auto b) {
+               return std::strcmp(a, b) < 0;
+            }));
+         }
+      }
    }
 
    //
@@ -150,6 +813,213 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
 
       for(auto l = 0u; l <= 10; ++l)
          for(auto n = 0u; n < l; ++n) test_it(build_u(l, n));
+
+      // (key, original position) pairs, so any instability shows
+      auto by_key = [](auto& a, auto& b) { return a.first < b.first; };
+      auto test_pairs = [&](std::vector<int> keys) {
+         std::vector<std::pair<int, int>> u(keys.size());
+         for(auto i = 0u; i < u.size(); ++i) u[i] = {keys[i], int(i)};
+         auto v = u;
+         std::stable_sort(begin(v), end(v), by_key);
+         learn_std::stable_sort(begin(u), end(u), by_key);
+         CATCH_REQUIRE(u == v);
+      };
+
+      for(auto len : {31u, 32u, 33u, 100u, 1000u, 20000u}) {
+         std::vector<int> u(len);
+         for(auto& x : u) x = rand(0, 1000000);
+         test_pairs(u); // random
+         for(auto& x : u) x = rand(0, 5);
+         test_pairs(u); // few distinct keys
+         iota(begin(u), end(u), 0);
+         test_pairs(u); // sorted
+         std::reverse(begin(u), end(u));
+         test_pairs(u); // strictly descending
+         for(auto i = 0u; i < len; ++i) u[i] = int(len - i) / 3;
+         test_pairs(u); // descending with ties
+         iota(begin(u), end(u), 0);
+         for(auto i = len - len / 10; i < len; ++i) u[i] = rand(0, int(len));
+         test_pairs(u); // sorted with random appended
+         for(auto i = 0u; i < len; ++i) u[i] = int(i % 100) + rand(0, 3);
+         test_pairs(u); // many short noisy runs
+      }
+
+      { // move-only elements
+         std::vector<std::unique_ptr<int>> u;
+         for(auto i = 0; i < 1000; ++i)
+            u.push_back(std::make_unique<int>(rand(0, 50)));
+         learn_std::stable_sort(
+             begin(u), end(u), [](auto& a, auto& b) { return *a < *b; });
+         CATCH_REQUIRE(std::is_sorted(
+             begin(u), end(u), [](auto& a, auto& b) { return *a < *b; }));
+      }
+   }
+
+   //
+   // -------------------------------------------------------- block-stable-sort
+   //
+   CATCH_SECTION("block-stable-sort")
+   {
+      g.seed(1);
+
+      // (key, original position) pairs, so any instability shows
+      auto by_key = [](auto& a, auto& b) { return a.first < b.first; };
+      auto test_pairs = [&](std::vector<int> keys) {
+         std::vector<std::pair<int, int>> u(keys.size());
+         for(auto i = 0u; i < u.size(); ++i) u[i] = {keys[i], int(i)};
+         auto v = u;
+         std::stable_sort(begin(v), end(v), by_key);
+         learn_std::block_stable_sort(begin(u), end(u), by_key);
+         CATCH_REQUIRE(u == v);
+      };
+
+      // From plenty of distinct keys to too few for a buffer, or any blocks
+      for(auto len : {0, 1, 2, 17, 100, 1000, 10000, 100000}) {
+         auto u    = std::vector<int>(std::size_t(len));
+         auto root = int(std::sqrt(len));
+         for(auto hi : {0, 1, 2, 9, root, len / 2, 1000000}) {
+            for(auto& x : u) x = rand(0, hi);
+            test_pairs(u);
+         }
+         iota(begin(u), end(u), 0);
+         test_pairs(u); // sorted
+         std::reverse(begin(u), end(u));
+         test_pairs(u); // strictly descending
+         for(auto i = 0; i < len; ++i) u[std::size_t(i)] = (len - i) / 3;
+         test_pairs(u); // descending with ties
+      }
+
+      { // strings, descending
+         std::vector<std::string> u(5000);
+         for(auto& s : u) s = std::to_string(rand(0, 3000));
+         auto v = u;
+         std::stable_sort(begin(v), end(v), std::greater<>{});
+         learn_std::block_stable_sort(begin(u), end(u), std::greater<>{});
+         CATCH_REQUIRE(u == v);
+      }
+
+      { // move-only elements
+         std::vector<std::unique_ptr<int>> u;
+         for(auto i = 0; i < 1000; ++i)
+            u.push_back(std::make_unique<int>(rand(0, 50)));
+         learn_std::block_stable_sort(
+             begin(u), end(u), [](auto& a, auto& b) { return *a < *b; });
+         CATCH_REQUIRE(std::is_sorted(
+             begin(u), end(u), [](auto& a, auto& b) { return *a < *b; }));
+      }
+   }
+
+   //
+   // --------------------------------------------------------------- sort-probe
+   //
+   CATCH_SECTION("sort-probe")
+   {
+      g.seed(1);
+      using learn_std::sort_engine;
+
+      // Sorts u both ways, and returns the engine that was picked
+      auto test_it = [&](auto u, auto comp) {
+         auto v = u;
+         std::sort(begin(v), end(v), comp);
+         learn_std::sort_stats stats;
+         learn_std::sort(begin(u), end(u), comp, stats);
+         CATCH_REQUIRE(u == v);
+         CATCH_REQUIRE(stats.size == u.size());
+         return stats;
+      };
+
+      const auto n = std::size_t(1) << 16;
+      std::vector<int> u(n);
+
+      { // Short ranges aren't probed
+         std::vector<int> w(100);
+         for(auto& x : w) x = rand(0, 1000000);
+         const auto stats = test_it(w, std::less<>{});
+         CATCH_REQUIRE(stats.sampled == 0);
+         CATCH_REQUIRE((stats.engine == sort_engine::introsort
+                        or stats.engine == sort_engine::simd_sort));
+      }
+
+      { // Sorted, reversed, sorted but for the tail, and a few runs
+         iota(begin(u), end(u), 0);
+         auto stats = test_it(u, std::less<>{});
+         CATCH_REQUIRE(stats.engine == sort_engine::run_merge);
+         CATCH_REQUIRE(stats.runs == 1.0);
+         CATCH_REQUIRE(stats.inversions == 0.0);
+         CATCH_REQUIRE(stats.sampled > 0);
+         CATCH_REQUIRE(stats.sampled < n / 16);
+
+         stats = test_it(u, std::greater<>{});
+         CATCH_REQUIRE(stats.engine == sort_engine::run_merge);
+         CATCH_REQUIRE(stats.inversions == 1.0);
+
+         for(auto i = n - n / 100; i < n; ++i) u[i] = rand(0, int(n));
+         CATCH_REQUIRE(test_it(u, std::less<>{}).engine
+                       == sort_engine::run_merge);
+
+         for(auto& x : u) x = rand(0, 1000000);
+         for(auto i = 0u; i < 8; ++i)
+            std::sort(begin(u) + i * n / 8, begin(u) + (i + 1) * n / 8);
+         CATCH_REQUIRE(test_it(u, std::less<>{}).engine
+                       == sort_engine::run_merge);
+      }
+
+      { // Shuffled, just past the threshold: slices of several pairs
+         for(auto len : {4096, 5000, 8000}) {
+            auto w = std::vector<uint64_t>(std::size_t(len));
+            for(auto& x : w) x = (uint64_t(g()) << 32) | g();
+            const auto stats = test_it(w, std::less<>{});
+            CATCH_REQUIRE(stats.sampled > 0);
+            CATCH_REQUIRE(stats.unsorted > 0.5);
+            CATCH_REQUIRE(stats.engine != sort_engine::run_merge);
+         }
+      }
+
+      { // Many duplicates, and scattered disorder
+         for(auto& x : u) x = rand(0, 100);
+         auto stats = test_it(u, std::less<>{});
+         CATCH_REQUIRE(stats.engine == sort_engine::pdq_sort);
+         CATCH_REQUIRE(stats.duplicates > 0.5);
+
+         iota(begin(u), end(u), 0);
+         for(auto i = 0u; i < n / 100; ++i)
+            std::swap(u[std::size_t(rand(0, int(n - 1)))],
+                      u[std::size_t(rand(0, int(n - 1)))]);
+         stats = test_it(u, std::less<>{});
+         CATCH_REQUIRE(stats.engine == sort_engine::pdq_sort);
+         CATCH_REQUIRE(stats.unsorted > 1.0 / 16);
+         CATCH_REQUIRE(stats.inversions < 1.0 / 16);
+      }
+
+      { // Integer keys spanning 2 bytes take radix sort, either way round
+         for(auto& x : u) x = rand(0, 60000);
+         auto stats = test_it(u, std::less<>{});
+         CATCH_REQUIRE(stats.engine == sort_engine::radix_sort);
+         CATCH_REQUIRE(stats.inversions > 0.4);
+         CATCH_REQUIRE(stats.inversions < 0.6);
+         CATCH_REQUIRE(stats.duplicates < 0.1);
+         CATCH_REQUIRE(test_it(u, std::greater<int>{}).engine
+                       == sort_engine::radix_sort);
+
+         // Wider keys don't
+         for(auto& x : u) x = rand(-1000000000, 1000000000);
+         stats = test_it(u, std::less<>{});
+         CATCH_REQUIRE((stats.engine == sort_engine::simd_sort
+                        or stats.engine == sort_engine::pdq_sort));
+         CATCH_REQUIRE(learn_std::sort_probe(begin(u), end(u)).engine
+                       == stats.engine);
+      }
+
+      { // Keys that radix sort and the SIMD quicksort can't take
+         std::vector<std::string> s(n / 4);
+         for(auto& x : s) x = std::to_string(rand(0, 1000000));
+         CATCH_REQUIRE(test_it(s, std::greater<>{}).engine
+                       == sort_engine::pdq_sort);
+         std::vector<int16_t> w(n);
+         for(auto& x : w) x = int16_t(rand(-30000, 30000));
+         CATCH_REQUIRE(test_it(w, [](int a, int b) { return a < b; }).engine
+                       == sort_engine::pdq_sort);
+      }
    }
 
    //
@@ -179,6 +1049,55 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
       for(auto l = 0u; l <= 10; ++l)
          for(auto n = 0u; n < l; ++n)
             for(auto r = 0; r < 1000; ++r) test_it(build_u(l), n);
+
+      // Larger inputs cover Floyd-Rivest sampling and the patterns that
+      // make a fixed pivot quadratic
+      auto test_select = [&](const std::vector<int>& u, auto select) {
+         auto v = u;
+         std::sort(begin(v), end(v));
+         const auto len = std::ptrdiff_t(u.size());
+         for(auto n : {std::ptrdiff_t(0), len / 2, len * 99 / 100, len - 1}) {
+            auto w   = u;
+            auto nth = begin(w) + n;
+            select(begin(w), nth, end(w));
+            CATCH_REQUIRE(*nth == v[std::size_t(n)]);
+            CATCH_REQUIRE(std::all_of(
+                begin(w), nth, [&](auto& a) { return !(*nth < a); }));
+            CATCH_REQUIRE(std::all_of(
+                nth, end(w), [&](auto& a) { return !(a < *nth); }));
+         }
+      };
+
+      auto introselect = [](auto first, auto nth, auto last) {
+         learn_std::nth_element(first, nth, last);
+      };
+      auto median_of_medians = [](auto first, auto nth, auto last) {
+         learn_std::detail::median_of_medians_select(
+             first, nth, last, std::less<>{});
+      };
+
+      for(auto len : {17, 100, 601, 1000, 5000, 100000}) {
+         std::vector<int> u(static_cast<std::size_t>(len));
+         std::vector<std::vector<int>> patterns;
+
+         for(auto& x : u) x = rand(0, 1000000);
+         patterns.push_back(u);
+         for(auto& x : u) x = rand(0, 3);
+         patterns.push_back(u);
+         std::iota(begin(u), end(u), 0);
+         patterns.push_back(u);
+         std::reverse(begin(u), end(u));
+         patterns.push_back(u);
+         for(auto i = 0; i < len; ++i) u[std::size_t(i)] = std::min(i, len - i);
+         patterns.push_back(u);
+         std::fill(begin(u), end(u), 7);
+         patterns.push_back(u);
+
+         for(const auto& p : patterns) {
+            test_select(p, introselect);
+            test_select(p, median_of_medians);
+         }
+      }
    }
 
    //
@@ -207,6 +1126,41 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
       for(auto l = 0u; l <= 10; ++l)
          for(auto n = 0u; n < l; ++n)
             for(auto r = 0; r < 1000; ++r) test_it(build_u(l), n);
+
+      // Heap-select and introselect on either side of k = n/64, including
+      // reverse sorted input that exhausts heap-select's budget, all under
+      // a non-default comparator
+      auto test_large = [&](const std::vector<int>& u, std::size_t k) {
+         auto v = u;
+         std::sort(begin(v), end(v), std::greater<>{});
+         auto w = u;
+         learn_std::partial_sort(begin(w), begin(w) + long(k), end(w),
+                                 std::greater<>{});
+         CATCH_REQUIRE(std::equal(begin(w), begin(w) + long(k), begin(v)));
+         std::sort(begin(w) + long(k), end(w), std::greater<>{});
+         CATCH_REQUIRE(w == v);
+      };
+
+      for(auto len : {100u, 1000u, 20000u}) {
+         std::vector<int> u(len);
+         for(auto k : {1u, 2u, len / 64, len / 64 + 1, len / 3, len}) {
+            for(auto& x : u) x = rand(0, 1000000);
+            test_large(u, k);
+            for(auto& x : u) x = rand(0, 3);
+            test_large(u, k);
+            std::iota(begin(u), end(u), 0);
+            test_large(u, k);
+            std::reverse(begin(u), end(u));
+            test_large(u, k);
+         }
+      }
+
+      { // The budget really runs out on ascending input under greater
+         std::vector<int> u(4096);
+         std::iota(begin(u), end(u), 0);
+         CATCH_REQUIRE(!learn_std::detail::heap_select(
+             begin(u), begin(u) + 8, end(u), 100, std::greater<>{}));
+      }
    }
 
    //
@@ -241,4 +1195,296 @@ CATCH_TEST_CASE("SortingOperations_", "[sorting-operations]")
          for(auto n = 0u; n < l + 2; ++n)
             for(auto r = 0; r < 1000; ++r) test_it(build_u(l), n);
    }
+
+   //
+   // -------------------------------------------------------------------- top-k
+   //
+   CATCH_SECTION("top-k")
+   {
+      g.seed(1);
+
+      // The first n of u under comp, in order
+      auto expect = [](auto u, std::size_t n, auto comp) {
+         std::sort(begin(u), end(u), comp);
+         u.resize(std::min(n, u.size()));
+         return u;
+      };
+
+      { // Single pushes, in batches from vectors, pointers and a list
+         learn_std::top_k<int, 100> top;
+         CATCH_REQUIRE(top.empty());
+         CATCH_REQUIRE(top.capacity() == 100);
+
+         std::vector<int> all;
+         for(auto i = 0; i < 50; ++i) {
+            all.push_back(rand(-1000000, 1000000));
+            top.push(all.back());
+         }
+         CATCH_REQUIRE(top.sorted() == expect(all, 100, std::greater<>{}));
+
+         for(auto batch = 0; batch < 20; ++batch) {
+            std::vector<int> u(std::size_t(rand(0, 5000)));
+            for(auto& x : u) x = rand(-1000000, 1000000);
+            if(batch % 3 == 0) {
+               top.push(begin(u), end(u));
+            } else if(batch % 3 == 1) {
+               top.push(u.data(), u.data() + u.size());
+            } else {
+               std::list<int> l(begin(u), end(u));
+               top.push(begin(l), end(l));
+            }
+            all.insert(end(all), begin(u), end(u));
+            CATCH_REQUIRE(top.sorted() == expect(all, 100, std::greater<>{}));
+         }
+         CATCH_REQUIRE(top.full());
+         CATCH_REQUIRE(top.threshold() == top.sorted().back());
+
+         top.clear();
+         CATCH_REQUIRE(top.empty());
+      }
+
+      { // The smallest keys, with ties and ascending input
+         learn_std::top_k<double, 7, std::less<>> top;
+         std::vector<double> u(3000);
+         for(auto i = 0u; i < u.size(); ++i) u[i] = double(i % 10);
+         top.push(begin(u), end(u));
+         std::iota(begin(u), end(u), -1000.0);
+         top.push(begin(u), end(u));
+         std::vector<double> all(u);
+         for(auto i = 0u; i < u.size(); ++i) all.push_back(double(i % 10));
+         CATCH_REQUIRE(top.sorted() == expect(all, 7, std::less<>{}));
+      }
+
+      { // Keys without a SIMD path, and a custom comparator
+         auto by_length = [](const std::string& a, const std::string& b) {
+            return a.size() > b.size() or (a.size() == b.size() and a < b);
+         };
+         learn_std::top_k<std::string, 5, decltype(by_length)> top(by_length);
+         std::vector<std::string> u;
+         for(auto i = 0; i < 500; ++i)
+            u.push_back(std::string(std::size_t(rand(0, 40)), 'a')
+                        + std::to_string(i));
+         top.push(begin(u), end(u));
+         CATCH_REQUIRE(top.sorted() == expect(u, 5, by_length));
+      }
+   }
+
+   //
+   // ------------------------------------------------------------- sort-indices
+   //
+   CATCH_SECTION("sort-indices")
+   {
+      // Stable argsort by brute force
+      auto expect = [](const auto& u, auto comp) {
+         std::vector<std::size_t> idx(u.size());
+         std::iota(begin(idx), end(idx), std::size_t(0));
+         std::stable_sort(begin(idx), end(idx), [&](auto a, auto b) {
+            return comp(u[a], u[b]);
+         });
+         return idx;
+      };
+
+      auto test_type = [&](auto zero) {
+         using T = decltype(zero);
+         for(auto n : {0, 1, 2, 17, 100, 1000, 5000}) {
+            auto u = std::vector<T>(std::size_t(n));
+            for(auto& x : u) x = T(rand(-50, 50));
+            if(n > 2) u[1] = T(-0.0); // both zeros
+            for(auto& x : u) {
+               if(rand(0, 10) == 0) x = std::numeric_limits<T>::max();
+               if(rand(0, 10) == 0) x = std::numeric_limits<T>::lowest();
+            }
+            const auto lo = expect(u, std::less<>{});
+            const auto hi = expect(u, std::greater<>{});
+
+            CATCH_REQUIRE(learn_std::sort_indices(begin(u), end(u)) == lo);
+            CATCH_REQUIRE(learn_std::stable_sort_indices(begin(u), end(u))
+                          == lo);
+            CATCH_REQUIRE(
+                learn_std::sort_indices(begin(u), end(u), std::greater<T>{})
+                == hi);
+            CATCH_REQUIRE(learn_std::stable_sort_indices(
+                              u.data(), u.data() + n, std::greater<>{})
+                          == hi);
+         }
+      };
+
+      test_type(short(0));
+      test_type(int(0));
+      test_type(unsigned(0));
+      test_type(std::int64_t(0));
+      test_type(float(0));
+      test_type(double(0));
+
+      { // A narrow Index, and one that is too narrow
+         std::vector<int> u(300);
+         for(auto& x : u) x = rand(0, 1000);
+         auto idx = learn_std::sort_indices<std::uint16_t>(begin(u), end(u));
+         auto by_key = [&](auto a, auto b) { return u[a] < u[b]; };
+         CATCH_REQUIRE(std::is_sorted(begin(idx), end(idx), by_key));
+         CATCH_REQUIRE_THROWS_AS(
+             learn_std::sort_indices<std::uint8_t>(begin(u), end(u)),
+             std::length_error);
+         u.resize(256);
+         CATCH_REQUIRE(
+             learn_std::sort_indices<std::uint8_t>(begin(u), end(u)).size()
+             == 256);
+      }
+
+      { // The generic path, which leaves the range alone
+         auto by_length = [](const std::string& a, const std::string& b) {
+            return a.size() < b.size();
+         };
+         std::vector<std::string> u;
+         for(auto i = 0; i < 2000; ++i)
+            u.push_back(std::string(std::size_t(rand(0, 20)), 'x')
+                        + std::to_string(i));
+         const auto v = u;
+
+         const auto idx = learn_std::sort_indices(begin(u), end(u), by_length);
+         CATCH_REQUIRE(u == v);
+         CATCH_REQUIRE(std::is_permutation(
+             begin(idx), end(idx), begin(expect(u, by_length))));
+         auto by_key = [&](auto a, auto b) { return by_length(u[a], u[b]); };
+         CATCH_REQUIRE(std::is_sorted(begin(idx), end(idx), by_key));
+
+         const auto stable
+             = learn_std::stable_sort_indices(begin(u), end(u), by_length);
+         CATCH_REQUIRE(stable == expect(u, by_length));
+      }
+   }
+
+   //
+   // -------------------------------------------------------------- sort-by-key
+   //
+   CATCH_SECTION("sort-by-key")
+   {
+      for(auto n : {0, 1, 2, 17, 100, 1000, 10000}) {
+         // Keys with ties; values hold the original positions
+         auto keys = std::vector<int>(std::size_t(n));
+         for(auto& x : keys) x = rand(0, n / 4);
+         auto pos = std::vector<int>(std::size_t(n));
+         std::iota(begin(pos), end(pos), 0);
+         auto names = std::vector<std::string>(std::size_t(n));
+         for(auto i = 0; i < n; ++i) names[std::size_t(i)] = std::to_string(i);
+
+         for(auto descending : {false, true}) {
+            auto comp = [descending](int a, int b) {
+               return descending ? a > b : a < b;
+            };
+            auto expect = pos;
+            std::stable_sort(begin(expect), end(expect), [&](int a, int b) {
+               return comp(keys[std::size_t(a)], keys[std::size_t(b)]);
+            });
+
+            { // Two arrays, stable
+               auto k = keys;
+               auto v = pos;
+               learn_std::stable_sort_by_key(begin(k), end(k), begin(v), comp);
+               CATCH_REQUIRE(v == expect);
+               for(auto i = 0u; i < k.size(); ++i)
+                  CATCH_REQUIRE(k[i] == keys[std::size_t(v[i])]);
+            }
+
+            { // Three arrays, unstable
+               auto k = keys;
+               auto v = pos;
+               auto w = names;
+               learn_std::sort_by_key(
+                   k.data(),
+                   k.data() + n,
+                   learn_std::make_zip_iterator(begin(v), begin(w)),
+                   comp);
+               CATCH_REQUIRE(std::is_sorted(begin(k), end(k), comp));
+               for(auto i = 0u; i < k.size(); ++i) {
+                  CATCH_REQUIRE(k[i] == keys[std::size_t(v[i])]);
+                  CATCH_REQUIRE(w[i] == std::to_string(v[i]));
+               }
+            }
+         }
+
+         { // Default comparator
+            auto k = keys;
+            auto w = names;
+            learn_std::stable_sort_by_key(begin(k), end(k), begin(w));
+            CATCH_REQUIRE(std::is_sorted(begin(k), end(k)));
+            auto v      = pos;
+            auto expect = keys;
+            learn_std::sort_by_key(begin(expect), end(expect), begin(v));
+            CATCH_REQUIRE(expect == k);
+            for(auto i = 0u; i < k.size(); ++i)
+               CATCH_REQUIRE(k[i] == keys[std::size_t(v[i])]);
+         }
+      }
+   }
+
+   //
+   // ----------------------------------------------------------- segmented-sort
+   //
+   CATCH_SECTION("segmented-sort")
+   {
+      // Segments of every size class, in a shuffled order
+      auto make_offsets = [&](int segments) {
+         std::vector<int> offsets{0};
+         for(auto i = 0; i < segments; ++i) {
+            const auto r = rand(0, 9);
+            const auto n = r < 7   ? rand(0, 9)
+                           : r < 9 ? rand(9, 33)
+                                   : rand(33, 500);
+            offsets.push_back(offsets.back() + n);
+         }
+         return offsets;
+      };
+
+      auto expect = [](auto u, const std::vector<int>& offsets, auto comp) {
+         auto lo = 0;
+         for(auto hi : offsets) {
+            std::sort(begin(u) + lo, begin(u) + hi, comp);
+            lo = hi;
+         }
+         std::sort(begin(u) + lo, end(u), comp);
+         return u;
+      };
+
+      for(auto segments : {0, 1, 2, 10, 1000, 5000}) {
+         auto offsets = make_offsets(segments);
+         auto u       = std::vector<int>(std::size_t(offsets.back()));
+         for(auto& x : u) x = rand(0, 100);
+
+         auto v = u;
+         learn_std::segmented_sort(
+             begin(v), end(v), begin(offsets), end(offsets));
+         CATCH_REQUIRE(v == expect(u, offsets, std::less<>{}));
+
+         // Without the leading 0 and trailing n; a trailing segment
+         // past the last offset; descending
+         v = u;
+         std::list<int> inner(begin(offsets) + 1, end(offsets));
+         if(!inner.empty()) inner.pop_back();
+         learn_std::segmented_sort(
+             begin(v), end(v), begin(inner), end(inner), std::greater<>{});
+         const auto cuts = std::vector<int>(begin(inner), end(inner));
+         CATCH_REQUIRE(v == expect(u, cuts, std::greater<>{}));
+
+         // Keys without the branchless compare-exchange
+         auto w = std::vector<std::string>(u.size());
+         for(auto i = 0u; i < u.size(); ++i) w[i] = std::to_string(u[i]);
+         auto x = w;
+         learn_std::segmented_sort(
+             begin(x), end(x), begin(offsets), end(offsets));
+         CATCH_REQUIRE(x == expect(w, offsets, std::less<>{}));
+      }
+
+      { // Every tiny length, as one segment and among others
+         for(auto n = 0; n <= 9; ++n) {
+            auto u = std::vector<double>(std::size_t(3 * n));
+            for(auto& x : u) x = double(rand(-5, 5));
+            const std::vector<int> offsets{n, 2 * n};
+            auto v = u;
+            learn_std::segmented_sort(
+                v.data(), v.data() + v.size(), begin(offsets), end(offsets));
+            CATCH_REQUIRE(v == expect(u, offsets, std::less<>{}));
+         }
+      }
+   }
 }
@@ -0,0 +1,210 @@
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "algorithms/partitioning-operations.hxx"
+#include "algorithms/sorting-operations.hxx"
+#include "algorithms/zip-iterator.hxx"
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include "catch.hpp"
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+CATCH_TEST_CASE("ZipIterator_", "[zip-iterator]")
+{
+   std::mt19937 g;
+   g.seed(1);
+
+   //
+   // ------------------------------------------------------------ zip-reference
+   //
+   CATCH_SECTION("zip-reference")
+   {
+      vector<int> a{1, 2, 3};
+      vector<std::string> b{"one", "two", "three"};
+      auto it = learn_std::make_zip_iterator(begin(a), begin(b));
+
+      // Conversion copies, assignment writes through
+      std::tuple<int, std::string> t = it[0];
+      CATCH_REQUIRE(t == std::make_tuple(1, std::string("one")));
+      CATCH_REQUIRE(b[0] == "one");
+      it[1] = it[0];
+      CATCH_REQUIRE(a[1] == 1);
+      CATCH_REQUIRE(b[1] == "one");
+      it[0] = std::make_tuple(5, std::string("five"));
+      CATCH_REQUIRE(a[0] == 5);
+      CATCH_REQUIRE(b[0] == "five");
+
+      // Swaps the elements, not the references
+      using std::swap;
+      swap(it[0], it[2]);
+      CATCH_REQUIRE(a == vector<int>{3, 1, 5});
+      CATCH_REQUIRE(b == vector<std::string>{"three", "one", "five"});
+
+      // get and structured bindings
+      using std::get;
+      get<0>(it[1]) = 7;
+      CATCH_REQUIRE(a[1] == 7);
+      auto [x, y] = *it;
+      x           = 9;
+      CATCH_REQUIRE(a[0] == 9);
+      CATCH_REQUIRE(y == "three");
+
+      // Comparisons, against references and values
+      CATCH_REQUIRE(it[1] < it[0]);
+      CATCH_REQUIRE(!(it[0] < it[0]));
+      CATCH_REQUIRE(it[2] == std::make_tuple(5, std::string("five")));
+      CATCH_REQUIRE(std::make_tuple(5, std::string("fiv")) < it[2]);
+   }
+
+   //
+   // ------------------------------------------------------------- zip-iterator
+   //
+   CATCH_SECTION("zip-iterator")
+   {
+      vector<int> a(10);
+      vector<double> b(10);
+      std::iota(begin(a), end(a), 0);
+      std::iota(begin(b), end(b), 0.5);
+
+      auto first = learn_std::make_zip_iterator(begin(a), begin(b));
+      auto last  = learn_std::make_zip_iterator(end(a), end(b));
+      CATCH_REQUIRE(last - first == 10);
+      CATCH_REQUIRE(first + 10 == last);
+      CATCH_REQUIRE(10 + first == last);
+      CATCH_REQUIRE(last - 10 == first);
+      CATCH_REQUIRE(first < last);
+      CATCH_REQUIRE(first <= first);
+      CATCH_REQUIRE(last > first);
+      CATCH_REQUIRE(last >= last);
+
+      auto it = first;
+      CATCH_REQUIRE(it++ == first);
+      CATCH_REQUIRE(++it - first == 2);
+      CATCH_REQUIRE(it-- - first == 2);
+      CATCH_REQUIRE(--it == first);
+      it += 4;
+      it -= 1;
+      CATCH_REQUIRE(std::get<1>(it.iterators()) == begin(b) + 3);
+      const decltype(first)::value_type value = *it;
+      CATCH_REQUIRE(value == std::make_tuple(3, 3.5));
+      CATCH_REQUIRE(std::count_if(first, last, [](const auto& x) {
+                       using std::get;
+                       return get<1>(x) > 4.0;
+                    })
+                    == 6);
+   }
+
+   //
+   // ---------------------------------------------------------- with-algorithms
+   //
+   CATCH_SECTION("with-algorithms")
+   {
+      // Keys with many ties, and values that record where each key started
+      auto make = [&](int n) {
+         auto keys = vector<int>(std::size_t(n));
+         for(auto& x : keys) x = int(g() % 50);
+         auto values = vector<int>(std::size_t(n));
+         std::iota(begin(values), end(values), 0);
+         return std::make_pair(keys, values);
+      };
+
+      // The same data as an array of pairs
+      auto as_pairs = [](const vector<int>& keys, const vector<int>& values) {
+         vector<std::pair<int, int>> pairs;
+         for(auto i = 0u; i < keys.size(); ++i)
+            pairs.emplace_back(keys[i], values[i]);
+         return pairs;
+      };
+
+      auto by_key = [](const auto& a, const auto& b) {
+         using std::get;
+         return get<0>(a) < get<0>(b);
+      };
+
+      for(auto n : {0, 1, 2, 10, 31, 100, 1000, 10000}) {
+         auto [keys, values] = make(n);
+         auto expect         = as_pairs(keys, values);
+
+         { // sort, lexicographically
+            auto k = keys;
+            auto v = values;
+            auto e = expect;
+            std::sort(begin(e), end(e));
+            learn_std::sort(learn_std::make_zip_iterator(begin(k), begin(v)),
+                            learn_std::make_zip_iterator(end(k), end(v)));
+            CATCH_REQUIRE(as_pairs(k, v) == e);
+         }
+
+         { // stable_sort, by key
+            auto k = keys;
+            auto v = values;
+            auto e = expect;
+            std::stable_sort(begin(e), end(e), by_key);
+            learn_std::stable_sort(
+                learn_std::make_zip_iterator(begin(k), begin(v)),
+                learn_std::make_zip_iterator(end(k), end(v)),
+                by_key);
+            CATCH_REQUIRE(as_pairs(k, v) == e);
+         }
+
+         { // pdq_sort, by key: values stay attached to their keys
+            auto k = keys;
+            auto v = values;
+            learn_std::pdq_sort(
+                learn_std::make_zip_iterator(begin(k), begin(v)),
+                learn_std::make_zip_iterator(end(k), end(v)),
+                by_key);
+            CATCH_REQUIRE(std::is_sorted(begin(k), end(k)));
+            for(auto i = 0u; i < k.size(); ++i)
+               CATCH_REQUIRE(keys[std::size_t(v[i])] == k[i]);
+         }
+
+         { // stable_partition and partition
+            auto k    = keys;
+            auto v    = values;
+            auto e    = expect;
+            auto even = [](const auto& x) {
+               using std::get;
+               return get<0>(x) % 2 == 0;
+            };
+            std::stable_partition(begin(e), end(e), even);
+            auto f = learn_std::make_zip_iterator(begin(k), begin(v));
+            auto l = learn_std::make_zip_iterator(end(k), end(v));
+            auto p = learn_std::stable_partition(f, l, even);
+            CATCH_REQUIRE(as_pairs(k, v) == e);
+            CATCH_REQUIRE(std::all_of(f, p, even));
+
+            std::copy(begin(keys), end(keys), begin(k));
+            std::copy(begin(values), end(values), begin(v));
+            p = learn_std::partition(f, l, even);
+            CATCH_REQUIRE(std::all_of(f, p, even));
+            CATCH_REQUIRE(std::none_of(p, l, even));
+            for(auto i = 0u; i < k.size(); ++i)
+               CATCH_REQUIRE(keys[std::size_t(v[i])] == k[i]);
+         }
+
+         if(n > 0) { // nth_element
+            auto k   = keys;
+            auto v   = values;
+            auto f   = learn_std::make_zip_iterator(begin(k), begin(v));
+            auto l   = learn_std::make_zip_iterator(end(k), end(v));
+            auto nth = f + n / 3;
+            learn_std::nth_element(f, nth, l, by_key);
+            auto s = keys;
+            std::sort(begin(s), end(s));
+            CATCH_REQUIRE(k[std::size_t(n / 3)] == s[std::size_t(n / 3)]);
+            for(auto i = 0u; i < k.size(); ++i)
+               CATCH_REQUIRE(keys[std::size_t(v[i])] == k[i]);
+         }
+      }
+   }
+}